@@ -0,0 +1,36 @@
+#!/bin/sh
+# Ablation of the redundant clause families: generates puzzles for a fixed set of seeds with each
+# family switched on/off and reports the solver's conflicts and the wall-clock time per run.
+#
+# usage: scripts/ablation.sh [WIDTH HEIGHT [EXTRA OPTIONS]...]
+#   e.g. scripts/ablation.sh 6 6 --encoding edge
+
+BIN="$(dirname "$0")/../bin/alcazar-gen"
+WIDTH=${1:-5}
+HEIGHT=${2:-5}
+[ $# -ge 2 ] && shift 2
+SEEDS="1 2 3 4 5 6 7 8"
+
+printf "%-32s %6s %12s %10s\n" "config" "seed" "conflicts" "time[s]"
+for config in "" "--edge-escape" "--boundary-parity" "--edge-escape --boundary-parity" "--nodes off" "--non-neighbours off"
+do
+    total_conflicts=0
+    total_time=0
+    for seed in $SEEDS
+    do
+        start=$(date +%s.%N)
+        if ! output=$("$BIN" "$WIDTH" "$HEIGHT" --seed "$seed" $config "$@")
+        then
+            # e.g. --boundary-parity with another encoding than edge
+            printf "%-32s %s\n\n" "${config:-(none)}" "$(echo "$output" | grep '^Error')"
+            continue 2
+        fi
+        conflicts=$(echo "$output" | sed -n 's/^Info: solver statistics: \([0-9]*\) conflicts.*/\1/p')
+        end=$(date +%s.%N)
+        time=$(awk "BEGIN { print $end - $start }")
+        printf "%-32s %6s %12s %10.2f\n" "${config:-(none)}" "$seed" "$conflicts" "$time"
+        total_conflicts=$((total_conflicts + conflicts))
+        total_time=$(awk "BEGIN { print $total_time + $time }")
+    done
+    printf "%-32s %6s %12s %10.2f\n\n" "${config:-(none)}" "total" "$total_conflicts" "$total_time"
+done
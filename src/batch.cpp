@@ -0,0 +1,271 @@
+/*******************************************************************************
+* alcazar-gen
+*
+* Copyright (c) 2015 Florian Pigorsch
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+
+#include "batch.h"
+#include "board.h"
+#include "generator.h"
+#include "workStealingPool.h"
+
+
+namespace
+{
+    // the DIMACS files of puzzle i are named <prefix>-<i>-<source>-<n>-<stage>.cnf
+    std::string puzzlePrefix(const std::string& prefix, int puzzle)
+    {
+        if (prefix.empty())
+        {
+            return prefix;
+        }
+        std::ostringstream os;
+        os << prefix << "-" << std::setw(4) << std::setfill('0') << puzzle;
+        return os.str();
+    }
+
+
+    std::string sizeName(const TemplateBoard& templateBoard)
+    {
+        std::ostringstream os;
+        os << templateBoard.width() << "x" << templateBoard.height();
+        return os.str();
+    }
+
+
+    // index of the manifest's template (WIDTHxHEIGHT or file), reading it on first use; -1 on errors
+    int addTemplate(const std::string& name, Batch& batch)
+    {
+        for (unsigned int i = 0; i < batch.names.size(); ++i)
+        {
+            if (batch.names[i] == name) return i;
+        }
+
+        TemplateBoard templateBoard;
+        int width = 0;
+        int height = 0;
+        char x = 0;
+        std::istringstream is(name);
+        if (is >> width >> x >> height && x == 'x' && is.peek() == EOF)
+        {
+            if (width < 2 || height < 2)
+            {
+                std::cout << "Error: bad board size '" << name << "' (WIDTH and HEIGHT must be >= 2)" << std::endl;
+                return -1;
+            }
+            templateBoard = TemplateBoard(width, height);
+        }
+        else if (!readTemplateFile(name, templateBoard))
+        {
+            return -1;
+        }
+
+        batch.templates.push_back(templateBoard);
+        batch.names.push_back(name);
+        return static_cast<int>(batch.templates.size()) - 1;
+    }
+}
+
+
+bool readManifest(const std::string& fileName, Batch& batch)
+{
+    std::ifstream file(fileName);
+    if (!file)
+    {
+        std::cout << "Error: cannot open manifest file '" << fileName << "' for reading" << std::endl;
+        return false;
+    }
+
+    std::string line;
+    for (int lineNumber = 1; std::getline(file, line); ++lineNumber)
+    {
+        line = line.substr(0, line.find('#'));
+        std::istringstream is(line);
+        std::string name;
+        if (!(is >> name)) continue;
+
+        BatchJob job;
+        if (!(is >> job.seed >> job.count) || job.count < 1 || (!(is >> job.priority) && !is.eof()) || !(is >> std::ws).eof())
+        {
+            std::cout << "Error: syntax error in manifest file '" << fileName << "', line " << lineNumber << " (expected: TEMPLATE SEED COUNT [PRIORITY])" << std::endl;
+            return false;
+        }
+        job.templateIndex = addTemplate(name, batch);
+        if (job.templateIndex < 0)
+        {
+            return false;
+        }
+        batch.jobs.push_back(job);
+    }
+
+    if (batch.jobs.empty())
+    {
+        std::cout << "Error: manifest file '" << fileName << "' contains no jobs" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+
+bool runBatch(const Batch& batch, const Options& options, std::ostream& os)
+{
+    std::vector<PreparedFormula> formulas(batch.templates.size());
+    std::vector<bool> used(batch.templates.size(), false);
+    for (const auto& job: batch.jobs)
+    {
+        used[job.templateIndex] = true;
+    }
+    for (unsigned int i = 0; i < batch.templates.size(); ++i)
+    {
+        if (used[i])
+        {
+            prepareFormula(batch.templates[i], options.formula, options.formulaCache, formulas[i], os);
+        }
+    }
+
+    std::atomic<bool> success(true);
+    std::mutex outputMutex;
+
+    // each worker's generator (and log) per template; with options.solver.reuse, it serves all of the worker's puzzles
+    // of the template, otherwise a new one is created for each puzzle
+    struct WorkerGenerator
+    {
+        std::ostringstream log;
+        std::unique_ptr<Generator> generator;
+    };
+    WorkStealingPool pool(options.jobs);
+    std::vector<std::vector<WorkerGenerator>> generators(pool.workers());
+    for (auto& workerGenerators: generators)
+    {
+        workerGenerators = std::vector<WorkerGenerator>(batch.templates.size());
+    }
+
+    const auto generate = [&](const BatchJob& job, unsigned int seed, int puzzle, int worker)
+    {
+        DimacsOptions dimacs = options.dimacs;
+        dimacs.dumpPrefix = puzzlePrefix(dimacs.dumpPrefix, puzzle);
+        dimacs.importPrefix = puzzlePrefix(dimacs.importPrefix, puzzle);
+
+        WorkerGenerator& w = generators[worker][job.templateIndex];
+        std::ostringstream& log = w.log;
+        log.str("");
+        if (w.generator && options.solver.reuse)
+        {
+            w.generator->setSeed(seed);
+            w.generator->setDimacs(dimacs);
+        }
+        else
+        {
+            w.generator.reset(new Generator(batch.templates[job.templateIndex], options.formula, dimacs, options.solver, options.formulaCache, seed, log));
+            w.generator->setFormula(&formulas[job.templateIndex]);
+        }
+        const GeneratorResult result = w.generator->get();
+        if (!options.solver.reuse)
+        {
+            w.generator.reset();
+        }
+
+        // with a reused solver, the puzzle also depends on the worker's earlier puzzles, so its seed does not reproduce it
+        std::ostringstream label;
+        label << "#" << puzzle << " (" << batch.names[job.templateIndex];
+        if (!options.solver.reuse)
+        {
+            label << ", seed " << seed;
+        }
+        label << ")";
+
+        std::ostringstream out;
+        if (result.board.width() == 0)
+        {
+            // the generator's log explains the failure
+            out << "Error: puzzle " << label.str() << " could not be generated:\n" << log.str() << std::endl;
+            success = false;
+        }
+        else
+        {
+            out << "Puzzle " << label.str() << ":\n" << result.board << std::endl;
+            if (options.solve)
+            {
+                const std::tuple<bool, bool, Path> solution = result.board.solve(options.formula, dimacs, options.solver, options.formulaCache, out, &result.certificate);
+                printSolution(out, result.board, solution);
+                out << std::endl;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(outputMutex);
+        os << out.str() << std::flush;
+    };
+
+    int puzzles = 0;
+    for (const auto& job: batch.jobs)
+    {
+        unsigned int master = job.seed;
+        if (master == 0)
+        {
+            master = std::random_device()();
+        }
+        os << "Info: puzzles #" << (puzzles + 1) << "-#" << (puzzles + job.count) << " (" << batch.names[job.templateIndex] << ") use master seed " << master << std::endl;
+        for (int i = 0; i < job.count; ++i)
+        {
+            const unsigned int seed = deriveSeed(master, i);
+            const int puzzle = ++puzzles;
+            pool.add([&generate, &job, seed, puzzle](int worker) { generate(job, seed, puzzle, worker); }, job.priority);
+        }
+    }
+
+    os << "Info: generating " << puzzles << " puzzles with " << pool.workers() << " threads" << std::endl;
+    pool.run();
+
+    for (int worker = 0; worker < pool.workers(); ++worker)
+    {
+        const WorkStealingPool::WorkerStats& stats = pool.stats(worker);
+        os << "Info: worker " << worker << ": " << stats.tasks << " puzzles (" << stats.stolen << " stolen), busy "
+           << std::fixed << std::setprecision(2) << stats.busySeconds << " s of " << pool.wallSeconds() << " s ("
+           << std::setprecision(0) << (pool.wallSeconds() > 0 ? 100 * stats.busySeconds / pool.wallSeconds() : 0) << "%)"
+           << std::defaultfloat << std::setprecision(6) << std::endl;
+    }
+
+    return success;
+}
+
+
+bool generateBatch(const TemplateBoard& templateBoard, const Options& options, std::ostream& os)
+{
+    Batch batch;
+    batch.templates.push_back(templateBoard);
+    batch.names.push_back(options.templateFile.empty() ? sizeName(templateBoard) : options.templateFile);
+
+    BatchJob job;
+    job.seed = options.seed;
+    job.count = options.count;
+    batch.jobs.push_back(job);
+
+    return runBatch(batch, options, os);
+}
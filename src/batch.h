@@ -0,0 +1,63 @@
+/*******************************************************************************
+* alcazar-gen
+*
+* Copyright (c) 2015 Florian Pigorsch
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "commandline.h"
+#include "templateBoard.h"
+
+// `count` puzzles of one template; puzzle i uses deriveSeed(seed, i) (with a random master seed if seed is 0)
+struct BatchJob
+{
+    int templateIndex = 0;
+    unsigned int seed = 0;
+    int count = 1;
+    // jobs of higher priority are started first
+    int priority = 0;
+};
+
+struct Batch
+{
+    std::vector<TemplateBoard> templates;
+    // template file or WIDTHxHEIGHT, for the output
+    std::vector<std::string> names;
+    std::vector<BatchJob> jobs;
+};
+
+// Job manifest: one job per line, "TEMPLATE MASTER-SEED COUNT [PRIORITY]", where TEMPLATE is a template file or WIDTHxHEIGHT
+// for an empty board; '#' starts a comment. Each template file is parsed once.
+bool readManifest(const std::string& fileName, Batch& batch);
+
+// Generates the puzzles of all jobs on a work-stealing pool of options.jobs workers. The formula of each template is
+// built (or loaded from the cache) once and shared read-only; each worker runs its own generators and solvers.
+// Puzzles are written to os as they complete, followed by each worker's utilisation; returns false if any puzzle could
+// not be generated.
+bool runBatch(const Batch& batch, const Options& options, std::ostream& os);
+
+// options.count puzzles of the template (--count) with the master seed options.seed
+bool generateBatch(const TemplateBoard& templateBoard, const Options& options, std::ostream& os);
@@ -22,11 +22,12 @@
 * SOFTWARE.
 *******************************************************************************/
 
-#include <core/Solver.h>
-#include <simp/SimpSolver.h>
-
 #include "board.h"
+#include "clauseSink.h"
 #include "formula.h"
+#include "formulaCache.h"
+#include "satSolver.h"
+#include "templateBoard.h"
 
 Board::Board(int w, int h) :
     m_width(w),
@@ -34,52 +35,67 @@ Board::Board(int w, int h) :
 {}
 
 
-std::tuple<bool, bool, Path> Board::solve() const
+bool Board::isCertified(const SolutionCertificate& certificate) const
+{
+    if (certificate.path.size() != static_cast<unsigned int>(m_width * m_height))
+    {
+        return false;
+    }
+    for (auto wall: certificate.walls)
+    {
+        if (!hasWall(wall)) return false;
+    }
+    return certificate.path.getBlockingWalls(m_walls).empty();
+}
+
+
+std::tuple<bool, bool, Path> Board::solve(const FormulaOptions& options, const DimacsOptions& dimacs, const SolverOptions& solver, const std::string& cacheDirectory,
+                                          std::ostream& log, const SolutionCertificate* certificate) const
 {
+    if (certificate != nullptr && isCertified(*certificate))
+    {
+        return std::make_tuple(true, true, certificate->path);
+    }
+
+    QuerySolver query(dimacs, solver, "board", log);
     SatSolver s;
-    std::map<std::pair<int, int>, Minisat::Lit> fp2lit;
-    std::map<Wall, Minisat::Lit> w2lit;
-    buildFormula(m_width, m_height, s, fp2lit, w2lit);
-    
-    const int pathLength = m_width * m_height;
+    if (!solver.preprocess)
+    {
+        s.disablePreprocessing();
+    }
+    s.setRecording(query.needsRecording());
+    FormulaLayout layout;
+    SolverSink sink(s);
+    loadFormula(cacheDirectory, TemplateBoard(m_width, m_height), options, sink, layout, log);
+    if (solver.preprocess)
+    {
+        preprocessFormula(s, layout);
+    }
     
     // assumptions: current walls
     Minisat::vec<Minisat::Lit> wallAssumptions;
-    for (auto wall = w2lit.begin(); wall != w2lit.end(); ++wall)
+    for (int id = 0; id < layout.walls(); ++id)
     {
-        if (hasWall(wall->first))
+        if (hasWall(Wall::fromId(id, m_width, m_height)))
         {
-            wallAssumptions.push(wall->second);
+            wallAssumptions.push(layout.wall(id));
         }
         else
         {
-            wallAssumptions.push(~wall->second);
+            wallAssumptions.push(~layout.wall(id));
         }
     }
     
-    bool satisfiable = s.solve(wallAssumptions);
+    bool satisfiable = (query.solve(s, layout, wallAssumptions, "solve") == l_True);
     if (satisfiable)
     {
         // path found
-        Path path(pathLength);
-        Minisat::vec<Minisat::Lit> pathClause;
-        for (int field = 0; field < pathLength; ++field)
-        {
-            for (int pos = 0; pos < pathLength; ++pos)
-            {
-                const auto lit = fp2lit[{field, pos}];
-                const Minisat::lbool value = s.modelValue(lit);
-                
-                if (Minisat::toInt(value) == 0 /* = Minisat::l_True */)
-                {
-                    path.set(pos, coord(field));
-                    pathClause.push(~lit);
-                }
-            }
-        }
+        const Path path = extractPath(s, layout);
+        Minisat::vec<Minisat::Lit> blockingClause;
+        pathClause(layout, path, blockingClause);
         
-        s.addClause(pathClause);
-        satisfiable = s.solve(wallAssumptions);
+        s.addClause(blockingClause);
+        satisfiable = (query.solve(s, layout, wallAssumptions, "unique") == l_True);
         
         if (satisfiable)
         {
@@ -185,3 +201,28 @@ std::ostream& operator<<(std::ostream& os, const Board& board)
     board.print(os, Path());
     return os;
 }
+
+
+void printSolution(std::ostream& os, const Board& board, const std::tuple<bool, bool, Path>& solution)
+{
+    if (std::get<0>(solution))
+    {
+        os << "Board is solvable" << std::endl;
+        
+        if (std::get<1>(solution))
+        {
+            os << "Board is uniquely solvable" << std::endl;
+        }
+        else
+        {
+            os << "Board is NOT uniquely solvable" << std::endl;
+        }
+        
+        os << "Solution:" << std::endl;
+        board.print(os, std::get<2>(solution));
+    }
+    else
+    {
+        os << "Board is NOT solvable" << std::endl;
+    }
+}
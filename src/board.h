@@ -26,12 +26,25 @@
 
 #include <iostream>
 #include <set>
+#include <string>
 #include <tuple>
 #include "coordinates.h"
+#include "dimacs.h"
+#include "formula.h"
 #include "path.h"
+#include "satSolver.h"
 #include "wall.h"
 
 
+// Known solution of a board: the path is the board's only solution if all of the walls are closed and the board's
+// other walls do not block the path (e.g. proven by the generator's final wall removal queries).
+struct SolutionCertificate
+{
+    Path path;
+    std::set<Wall> walls;
+};
+
+
 class Board
 {
     public:
@@ -44,7 +57,10 @@ class Board
         int index(const Coordinates& c) const { return index(c.x(), c.y()); }
         Coordinates coord(int index) const { return Coordinates(index % m_width, index / m_width); }
         
-        std::tuple<bool, bool, Path> solve() const;
+        // returns (solvable, unique, path); a matching certificate answers without building and solving the formula;
+        // messages (formula cache) go to the log
+        std::tuple<bool, bool, Path> solve(const FormulaOptions& options, const DimacsOptions& dimacs, const SolverOptions& solver, const std::string& cacheDirectory,
+                                           std::ostream& log, const SolutionCertificate* certificate = nullptr) const;
         
         void addWall(const Wall& w) { m_walls.insert(w); }
         bool hasWall(const Wall& w) const { return m_walls.find(w) != m_walls.end(); }
@@ -52,6 +68,8 @@ class Board
         void print(std::ostream& os, const Path& path) const;
     
     private:
+        bool isCertified(const SolutionCertificate& certificate) const;
+
         int m_width = 0;
         int m_height = 0;
         
@@ -59,3 +77,6 @@ class Board
 };
 
 std::ostream& operator<<(std::ostream& os, const Board& board);
+
+// result of Board::solve as printed by --solve
+void printSolution(std::ostream& os, const Board& board, const std::tuple<bool, bool, Path>& solution);
@@ -0,0 +1,240 @@
+/*******************************************************************************
+* alcazar-gen
+*
+* Copyright (c) 2015 Florian Pigorsch
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+
+#include "cardinality.h"
+#include "clauseSink.h"
+
+typedef Minisat::vec<Minisat::Lit> Clause;
+
+
+bool parseAmoEncoding(const std::string& name, AmoEncoding& encoding)
+{
+    if (name == "pairwise")   { encoding = AmoEncoding::Pairwise;   return true; }
+    if (name == "sequential") { encoding = AmoEncoding::Sequential; return true; }
+    if (name == "commander")  { encoding = AmoEncoding::Commander;  return true; }
+    if (name == "product")    { encoding = AmoEncoding::Product;    return true; }
+    return false;
+}
+
+
+std::string toString(AmoEncoding encoding)
+{
+    switch (encoding)
+    {
+        case AmoEncoding::Pairwise:   return "pairwise";
+        case AmoEncoding::Sequential: return "sequential";
+        case AmoEncoding::Commander:  return "commander";
+        case AmoEncoding::Product:    return "product";
+    }
+    return "?";
+}
+
+
+// below this size all encodings fall back to the pairwise encoding
+const unsigned int pairwiseLimit = 6;
+
+
+void addPairwise(ClauseSink& s, const std::vector<Minisat::Lit>& lits)
+{
+    // x_i -> ~x_j for all i < j
+    for (unsigned int i = 0; i < lits.size(); ++i)
+    {
+        for (unsigned int j = i+1; j < lits.size(); ++j)
+        {
+            s.addClause(~lits[i], ~lits[j]);
+        }
+    }
+}
+
+
+void addSequential(ClauseSink& s, const std::vector<Minisat::Lit>& lits)
+{
+    // Sinz' sequential counter: r_i <=> "one of x_0..x_i is true"
+    //   x_i -> r_i,  r_i-1 -> r_i,  r_i-1 -> ~x_i
+    Minisat::Lit prev = Minisat::mkLit(s.newVar());
+    s.addClause(~lits[0], prev);
+    for (unsigned int i = 1; i + 1 < lits.size(); ++i)
+    {
+        const Minisat::Lit reg = Minisat::mkLit(s.newVar());
+        s.addClause(~lits[i], reg);
+        s.addClause(~prev, reg);
+        s.addClause(~prev, ~lits[i]);
+        prev = reg;
+    }
+    s.addClause(~prev, ~lits.back());
+}
+
+
+void addCommander(ClauseSink& s, const std::vector<Minisat::Lit>& lits)
+{
+    // Klieber/Kwon: split into groups of 3, each group gets a commander c <=> (x_1 + x_2 + x_3);
+    // pairwise AMO inside each group, recursive AMO over the commanders
+    const unsigned int groupSize = 3;
+    std::vector<Minisat::Lit> commanders;
+    for (unsigned int begin = 0; begin < lits.size(); begin += groupSize)
+    {
+        const unsigned int end = std::min<unsigned int>(begin + groupSize, lits.size());
+        const std::vector<Minisat::Lit> group(lits.begin() + begin, lits.begin() + end);
+        addPairwise(s, group);
+
+        const Minisat::Lit commander = Minisat::mkLit(s.newVar());
+        Clause clause;
+        clause.push(~commander);
+        for (auto lit: group)
+        {
+            s.addClause(~lit, commander);
+            clause.push(lit);
+        }
+        s.addClause(clause);
+        commanders.push_back(commander);
+    }
+    addAtMostOne(s, commanders, AmoEncoding::Commander);
+}
+
+
+void addProduct(ClauseSink& s, const std::vector<Minisat::Lit>& lits)
+{
+    // Chen's 2-product: place x_i on a p*q grid, x_i -> row_r(i) and x_i -> col_c(i),
+    // recursive AMO over the rows and the columns
+    const unsigned int p = static_cast<unsigned int>(std::ceil(std::sqrt(static_cast<double>(lits.size()))));
+    const unsigned int q = (lits.size() + p - 1) / p;
+
+    std::vector<Minisat::Lit> rows;
+    std::vector<Minisat::Lit> cols;
+    for (unsigned int r = 0; r < q; ++r) rows.push_back(Minisat::mkLit(s.newVar()));
+    for (unsigned int c = 0; c < p; ++c) cols.push_back(Minisat::mkLit(s.newVar()));
+
+    for (unsigned int i = 0; i < lits.size(); ++i)
+    {
+        s.addClause(~lits[i], rows[i / p]);
+        s.addClause(~lits[i], cols[i % p]);
+    }
+    addAtMostOne(s, rows, AmoEncoding::Product);
+    addAtMostOne(s, cols, AmoEncoding::Product);
+}
+
+
+void addAtMostOne(ClauseSink& s, const std::vector<Minisat::Lit>& lits, AmoEncoding encoding)
+{
+    if (lits.size() <= pairwiseLimit)
+    {
+        addPairwise(s, lits);
+        return;
+    }
+
+    switch (encoding)
+    {
+        case AmoEncoding::Pairwise:
+            addPairwise(s, lits);
+            break;
+        case AmoEncoding::Sequential:
+            addSequential(s, lits);
+            break;
+        case AmoEncoding::Commander:
+            addCommander(s, lits);
+            break;
+        case AmoEncoding::Product:
+            addProduct(s, lits);
+            break;
+    }
+}
+
+
+void addAtMostK(ClauseSink& s, const std::vector<Minisat::Lit>& lits, int k)
+{
+    const int n = lits.size();
+    if (n <= k)
+    {
+        return;
+    }
+    if (k == 0)
+    {
+        for (auto lit: lits) s.addClause(~lit);
+        return;
+    }
+
+    // Sinz' sequential counter: r_i,j <=> "at least j+1 of x_0..x_i are true"
+    std::vector<Minisat::Lit> prev;
+    for (int i = 0; i + 1 < n; ++i)
+    {
+        std::vector<Minisat::Lit> reg;
+        for (int j = 0; j < k; ++j)
+        {
+            reg.push_back(Minisat::mkLit(s.newVar()));
+        }
+
+        s.addClause(~lits[i], reg[0]);
+        if (i == 0)
+        {
+            for (int j = 1; j < k; ++j) s.addClause(~reg[j]);
+        }
+        else
+        {
+            for (int j = 0; j < k; ++j) s.addClause(~prev[j], reg[j]);
+            for (int j = 1; j < k; ++j) s.addClause(~lits[i], ~prev[j-1], reg[j]);
+            s.addClause(~lits[i], ~prev[k-1]);
+        }
+        prev = reg;
+    }
+    s.addClause(~lits[n-1], ~prev[k-1]);
+}
+
+
+void addExactlyOne(ClauseSink& s, const std::vector<Minisat::Lit>& lits, AmoEncoding encoding)
+{
+    Clause clause;
+    for (auto lit: lits)
+    {
+        clause.push(lit);
+    }
+    s.addClause(clause);
+
+    addAtMostOne(s, lits, encoding);
+}
+
+
+void addParity(ClauseSink& s, const std::vector<Minisat::Lit>& lits, bool odd)
+{
+    if (lits.empty())
+    {
+        if (odd) s.addClause(Clause());
+        return;
+    }
+
+    // sum_i <=> sum_i-1 ^ x_i
+    Minisat::Lit sum = lits[0];
+    for (unsigned int i = 1; i < lits.size(); ++i)
+    {
+        const Minisat::Lit next = Minisat::mkLit(s.newVar());
+        s.addClause(~next, sum, lits[i]);
+        s.addClause(~next, ~sum, ~lits[i]);
+        s.addClause(next, ~sum, lits[i]);
+        s.addClause(next, sum, ~lits[i]);
+        sum = next;
+    }
+    s.addClause(odd ? sum : ~sum);
+}
@@ -0,0 +1,47 @@
+/*******************************************************************************
+* alcazar-gen
+*
+* Copyright (c) 2015 Florian Pigorsch
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <core/SolverTypes.h>
+
+#include "formula.h"
+
+bool parseAmoEncoding(const std::string& name, AmoEncoding& encoding);
+std::string toString(AmoEncoding encoding);
+
+// at most one of the literals is true
+void addAtMostOne(ClauseSink& s, const std::vector<Minisat::Lit>& lits, AmoEncoding encoding);
+
+// at most k of the literals are true (sequential counter)
+void addAtMostK(ClauseSink& s, const std::vector<Minisat::Lit>& lits, int k);
+
+// exactly one of the literals is true
+void addExactlyOne(ClauseSink& s, const std::vector<Minisat::Lit>& lits, AmoEncoding encoding);
+
+// an odd (or even) number of the literals is true (chain of xors)
+void addParity(ClauseSink& s, const std::vector<Minisat::Lit>& lits, bool odd);
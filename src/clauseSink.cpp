@@ -0,0 +1,81 @@
+/*******************************************************************************
+* alcazar-gen
+*
+* Copyright (c) 2015 Florian Pigorsch
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+
+#include "clauseSink.h"
+
+
+void ClauseBuffer::replay(ClauseSink& sink) const
+{
+    while (sink.nVars() < m_vars)
+    {
+        sink.newVar();
+    }
+    for (int i = 0; i < size(); ++i)
+    {
+        sink.addClause(clause(i), clauseSize(i));
+    }
+}
+
+
+void ClauseBuffer::addClause_(const Minisat::Lit* lits, int size)
+{
+    m_offsets.push_back(static_cast<int>(m_lits.size()));
+    m_lits.insert(m_lits.end(), lits, lits + size);
+
+    // clauses may refer to variables created elsewhere (e.g. when recording a solver's clauses)
+    for (int i = 0; i < size; ++i)
+    {
+        if (Minisat::var(lits[i]) >= m_vars) m_vars = Minisat::var(lits[i]) + 1;
+    }
+}
+
+
+Minisat::Lit FoldingSink::constant()
+{
+    if (m_constant == Minisat::lit_Undef)
+    {
+        m_constant = Minisat::mkLit(m_sink.newVar());
+        m_sink.addClause(m_constant);
+    }
+    return m_constant;
+}
+
+
+void FoldingSink::addClause_(const Minisat::Lit* lits, int size)
+{
+    m_clause.clear();
+    for (int i = 0; i < size; ++i)
+    {
+        if (lits[i] == m_constant)
+        {
+            ++m_folded;
+            return;
+        }
+        if (lits[i] != ~m_constant)
+        {
+            m_clause.push_back(lits[i]);
+        }
+    }
+    m_sink.addClause(m_clause);
+}
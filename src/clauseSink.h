@@ -0,0 +1,122 @@
+/*******************************************************************************
+* alcazar-gen
+*
+* Copyright (c) 2015 Florian Pigorsch
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+
+#pragma once
+
+#include <vector>
+
+#include <core/SolverTypes.h>
+#include <mtl/Vec.h>
+
+// Receiver of the formula's variables and clauses (solver, DIMACS file, counter, buffer).
+class ClauseSink
+{
+    public:
+        virtual ~ClauseSink() = default;
+
+        virtual Minisat::Var newVar() = 0;
+        virtual int nVars() const = 0;
+        int nClauses() const { return m_clauses; }
+
+        void addClause(const Minisat::Lit* lits, int size) { ++m_clauses; addClause_(lits, size); }
+        void addClause(const Minisat::vec<Minisat::Lit>& clause) { addClause(clause.size() > 0 ? &clause[0] : nullptr, clause.size()); }
+        void addClause(const std::vector<Minisat::Lit>& clause) { addClause(clause.data(), static_cast<int>(clause.size())); }
+        void addClause(Minisat::Lit p) { addClause(&p, 1); }
+        void addClause(Minisat::Lit p, Minisat::Lit q) { const Minisat::Lit clause[] = {p, q}; addClause(clause, 2); }
+        void addClause(Minisat::Lit p, Minisat::Lit q, Minisat::Lit r) { const Minisat::Lit clause[] = {p, q, r}; addClause(clause, 3); }
+
+    protected:
+        virtual void addClause_(const Minisat::Lit* lits, int size) = 0;
+
+    private:
+        int m_clauses = 0;
+};
+
+
+// Only counts variables and clauses, e.g. to estimate the formula's size.
+class CountingSink : public ClauseSink
+{
+    public:
+        Minisat::Var newVar() override { return m_vars++; }
+        int nVars() const override { return m_vars; }
+        long long nLiterals() const { return m_literals; }
+
+    protected:
+        void addClause_(const Minisat::Lit*, int size) override { m_literals += size; }
+
+    private:
+        int m_vars = 0;
+        long long m_literals = 0;
+};
+
+
+// Passes the clauses on to another sink with one literal that is constant true: clauses containing it are satisfied
+// and dropped, and its negation is removed from the clauses. Its variable is created (with a unit clause) on first use.
+class FoldingSink : public ClauseSink
+{
+    public:
+        explicit FoldingSink(ClauseSink& sink) : m_sink(sink) {}
+
+        Minisat::Var newVar() override { return m_sink.newVar(); }
+        int nVars() const override { return m_sink.nVars(); }
+
+        // the literal that is constant true
+        Minisat::Lit constant();
+        // number of clauses dropped as satisfied
+        int nFolded() const { return m_folded; }
+
+    protected:
+        void addClause_(const Minisat::Lit* lits, int size) override;
+
+    private:
+        ClauseSink& m_sink;
+        Minisat::Lit m_constant = Minisat::lit_Undef;
+        std::vector<Minisat::Lit> m_clause;
+        int m_folded = 0;
+};
+
+
+// Flat in-memory formula: all literals in one array plus the clauses' start offsets. It can be replayed into any
+// number of sinks (e.g. fresh solvers) without rebuilding the formula.
+class ClauseBuffer : public ClauseSink
+{
+    public:
+        Minisat::Var newVar() override { return m_vars++; }
+        int nVars() const override { return m_vars; }
+
+        int size() const { return static_cast<int>(m_offsets.size()); }
+        const Minisat::Lit* clause(int i) const { return m_lits.data() + m_offsets[i]; }
+        int clauseSize(int i) const { return ((i + 1 < size()) ? m_offsets[i + 1] : static_cast<int>(m_lits.size())) - m_offsets[i]; }
+
+        // add the variables (if the sink has fewer) and all clauses to the sink
+        void replay(ClauseSink& sink) const;
+
+    protected:
+        void addClause_(const Minisat::Lit* lits, int size) override;
+
+    private:
+        int m_vars = 0;
+        std::vector<Minisat::Lit> m_lits;
+        std::vector<int> m_offsets;
+};
@@ -24,10 +24,18 @@
 
 #include <boost/program_options.hpp>
 #include <iostream>
+#include "cardinality.h"
 #include "commandline.h"
 
 namespace po = boost::program_options;
 
+bool parseSwitch(const std::string& value, bool& flag)
+{
+    if (value == "on")  { flag = true;  return true; }
+    if (value == "off") { flag = false; return true; }
+    return false;
+}
+
 void usage(char* program, const po::options_description& desc)
 {
     std::cout 
@@ -43,6 +51,28 @@ bool parseCommandLine(int argc, char** argv, Options& options)
         ("seed", po::value<unsigned int>(), "Set random seed")
         ("solve", "Solve generated puzzle")
         ("template", po::value<std::string>(), "Template file")
+        ("count", po::value<int>(), "Generate N puzzles")
+        ("jobs", po::value<int>(), "Generate the puzzles with J worker threads")
+        ("reuse-solver", "Each worker generates all its puzzles of a template with one solver")
+        ("race", po::value<int>(), "Race K generators with derived seeds, keep the first puzzle")
+        ("manifest", po::value<std::string>(), "Generate the jobs of the manifest file (lines: TEMPLATE|WxH SEED COUNT [PRIORITY])")
+        ("encoding", po::value<std::string>(), "Path encoding (position, edge, binary)")
+        ("amo-fields", po::value<std::string>(), "Encoding of 'each field appears once' (pairwise, sequential, commander, product)")
+        ("amo-positions", po::value<std::string>(), "Encoding of 'each position holds one field' (pairwise, sequential, commander, product)")
+        ("edge-escape", "Add redundant clauses: only the path's ends cross the border")
+        ("boundary-parity", "Add redundant clauses: parity of the path's crossings of straight cuts (edge encoding)")
+        ("nodes", po::value<std::string>(), "Redundant node orientation clauses (on, off; default: on)")
+        ("non-neighbours", po::value<std::string>(), "Redundant position encoding clauses f@p -> ~g@p+1 for non-neighbours g (on, off; default: on)")
+        ("dimacs", po::value<std::string>(), "Write every solver query to PREFIX-<source>-<n>-<stage>.cnf")
+        ("import", po::value<std::string>(), "Use external answers PREFIX-<source>-<n>-<stage>.core/.model where present")
+        ("portfolio", po::value<int>(), "Race K diversified solvers on every query")
+        ("cubes", po::value<int>(), "Split every query into cubes on the path's entry, solved by J solvers")
+        ("speculate", po::value<int>(), "Test K wall removal candidates at once on K solvers")
+        ("block-alternatives", "Add walls that block the alternative path of the last query instead of random walls")
+        ("quickxplain", "Find the needed walls by divide and conquer instead of adding and removing walls one by one")
+        ("backbone", "Drop the walls no alternative path crosses while adding walls (edge encoding)")
+        ("preprocess", po::value<std::string>(), "Preprocess the formula once before the first query (on, off; default: on)")
+        ("cache", po::value<std::string>(), "Load the formula from (or store it in) the cache directory DIR")
     ;
 
     po::options_description hidden("Hidden options");
@@ -86,13 +116,136 @@ bool parseCommandLine(int argc, char** argv, Options& options)
         }
         
         options.solve = vm.count("solve") > 0;
+
+        if (vm.count("count"))
+        {
+            options.count = vm["count"].as<int>();
+            if (options.count < 1)
+            {
+                throw std::invalid_argument("bad value for --count");
+            }
+        }
+        if (vm.count("jobs"))
+        {
+            options.jobs = vm["jobs"].as<int>();
+            if (options.jobs < 1)
+            {
+                throw std::invalid_argument("bad value for --jobs");
+            }
+        }
         
         if (vm.count("template"))
         {
             options.templateFile = vm["template"].as<std::string>();
         }
 
-        if ((options.width == 0 || options.height == 0) && options.templateFile.empty())
+        if (vm.count("encoding") && !parsePathEncoding(vm["encoding"].as<std::string>(), options.formula.pathEncoding))
+        {
+            throw std::invalid_argument("bad value for --encoding");
+        }
+        if (vm.count("amo-fields") && !parseAmoEncoding(vm["amo-fields"].as<std::string>(), options.formula.fieldAmo))
+        {
+            throw std::invalid_argument("bad value for --amo-fields");
+        }
+        if (vm.count("amo-positions") && !parseAmoEncoding(vm["amo-positions"].as<std::string>(), options.formula.positionAmo))
+        {
+            throw std::invalid_argument("bad value for --amo-positions");
+        }
+        options.formula.edgeEscape = vm.count("edge-escape") > 0;
+        options.formula.boundaryParity = vm.count("boundary-parity") > 0;
+        if (options.formula.boundaryParity && options.formula.pathEncoding != PathEncoding::Edge)
+        {
+            // only the edge encoding ties the crossed wall positions to the path
+            throw std::invalid_argument("--boundary-parity needs the edge encoding (--encoding edge)");
+        }
+        if (vm.count("nodes") && !parseSwitch(vm["nodes"].as<std::string>(), options.formula.nodeStructure))
+        {
+            throw std::invalid_argument("bad value for --nodes");
+        }
+        if (vm.count("non-neighbours") && !parseSwitch(vm["non-neighbours"].as<std::string>(), options.formula.nonNeighbours))
+        {
+            throw std::invalid_argument("bad value for --non-neighbours");
+        }
+
+        if (vm.count("dimacs"))
+        {
+            options.dimacs.dumpPrefix = vm["dimacs"].as<std::string>();
+        }
+        if (vm.count("import"))
+        {
+            options.dimacs.importPrefix = vm["import"].as<std::string>();
+        }
+        if (vm.count("portfolio"))
+        {
+            options.solver.portfolio = vm["portfolio"].as<int>();
+            if (options.solver.portfolio < 1)
+            {
+                throw std::invalid_argument("bad value for --portfolio");
+            }
+        }
+        if (vm.count("cubes"))
+        {
+            options.solver.cubes = vm["cubes"].as<int>();
+            if (options.solver.cubes < 1)
+            {
+                throw std::invalid_argument("bad value for --cubes");
+            }
+            if (options.solver.portfolio > 1)
+            {
+                throw std::invalid_argument("--cubes and --portfolio are exclusive");
+            }
+        }
+        if (vm.count("speculate"))
+        {
+            options.solver.speculate = vm["speculate"].as<int>();
+            if (options.solver.speculate < 1)
+            {
+                throw std::invalid_argument("bad value for --speculate");
+            }
+        }
+        options.solver.blockAlternatives = vm.count("block-alternatives") > 0;
+        options.solver.quickXplain = vm.count("quickxplain") > 0;
+        options.solver.reuse = vm.count("reuse-solver") > 0;
+        options.solver.backbone = vm.count("backbone") > 0;
+        if (options.solver.backbone && options.formula.pathEncoding != PathEncoding::Edge)
+        {
+            throw std::invalid_argument("--backbone needs the edge encoding (--encoding edge)");
+        }
+        if (options.solver.quickXplain && (options.solver.speculate > 1 || options.solver.blockAlternatives))
+        {
+            throw std::invalid_argument("--quickxplain replaces the wall adding and removal phases (no --block-alternatives or --speculate)");
+        }
+        if (vm.count("preprocess") && !parseSwitch(vm["preprocess"].as<std::string>(), options.solver.preprocess))
+        {
+            throw std::invalid_argument("bad value for --preprocess");
+        }
+        if (vm.count("cache"))
+        {
+            options.formulaCache = vm["cache"].as<std::string>();
+        }
+
+        if (vm.count("race"))
+        {
+            options.race = vm["race"].as<int>();
+            if (options.race < 1)
+            {
+                throw std::invalid_argument("bad value for --race");
+            }
+            if (options.count > 1 || vm.count("manifest"))
+            {
+                throw std::invalid_argument("--race generates a single puzzle (no --count or --manifest)");
+            }
+        }
+
+        if (vm.count("manifest"))
+        {
+            options.manifest = vm["manifest"].as<std::string>();
+            if (options.width != 0 || !options.templateFile.empty() || vm.count("count"))
+            {
+                throw std::invalid_argument("--manifest replaces dimensions (WIDTH and HEIGHT), --template and --count");
+            }
+        }
+        else if ((options.width == 0 || options.height == 0) && options.templateFile.empty())
         {
             throw std::invalid_argument("either dimensions (WIDTH and HEIGHT) or a template file (--template) must be specified");
         }
@@ -25,6 +25,9 @@
 #pragma once
 
 #include <string>
+#include "dimacs.h"
+#include "formula.h"
+#include "satSolver.h"
 
 struct Options
 {
@@ -32,7 +35,19 @@ struct Options
     int height = 0;
     bool solve = false;
     unsigned int seed = 0;
+    // number of puzzles and of worker threads generating them
+    int count = 1;
+    int jobs = 1;
+    // number of generators racing for the first puzzle
+    int race = 1;
     std::string templateFile;
+    // job manifest for batch generation (replaces dimensions/template)
+    std::string manifest;
+    FormulaOptions formula;
+    DimacsOptions dimacs;
+    SolverOptions solver;
+    // directory of the formula cache (disabled if empty)
+    std::string formulaCache;
 };
 
 bool parseCommandLine(int argc, char** argv, Options& options);
@@ -0,0 +1,333 @@
+/*******************************************************************************
+* alcazar-gen
+*
+* Copyright (c) 2015 Florian Pigorsch
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <ostream>
+#include <set>
+#include <sstream>
+
+#include "dimacs.h"
+#include "satSolver.h"
+
+
+std::uint64_t queryHash(const SatSolver& s, const Minisat::vec<Minisat::Lit>& assumptions)
+{
+    // FNV-1a
+    std::uint64_t hash = 14695981039346656037ull;
+    const auto add = [&hash](int value)
+    {
+        hash ^= static_cast<std::uint32_t>(value);
+        hash *= 1099511628211ull;
+    };
+
+    add(s.nVars());
+    const ClauseBuffer& formula = s.recorded();
+    for (int c = 0; c < formula.size(); ++c)
+    {
+        for (int i = 0; i < formula.clauseSize(c); ++i)
+        {
+            add(SatSolver::toDimacs(formula.clause(c)[i]));
+        }
+        add(0);
+    }
+    for (int i = 0; i < assumptions.size(); ++i)
+    {
+        add(SatSolver::toDimacs(assumptions[i]));
+    }
+    return hash;
+}
+
+
+DimacsWriter::DimacsWriter(std::ostream& os, int vars, int clauses) :
+    m_os(os)
+{
+    m_os << "p cnf " << vars << " " << clauses << "\n";
+}
+
+
+void DimacsWriter::addClause_(const Minisat::Lit* lits, int size)
+{
+    for (int i = 0; i < size; ++i)
+    {
+        m_os << SatSolver::toDimacs(lits[i]) << " ";
+    }
+    m_os << "0\n";
+}
+
+
+std::string hashComment(std::uint64_t hash)
+{
+    std::ostringstream os;
+    os << "c query " << std::hex << hash;
+    return os.str();
+}
+
+
+bool writeDimacs(const std::string& fileName, const SatSolver& s, const Minisat::vec<Minisat::Lit>& assumptions, const std::string& comment,
+                 std::ostream& log)
+{
+    std::ofstream file(fileName);
+    if (!file)
+    {
+        log << "Error: cannot open DIMACS file '" << fileName << "' for writing" << std::endl;
+        return false;
+    }
+
+    file << "c " << comment << "\n";
+    file << hashComment(queryHash(s, assumptions)) << "\n";
+    file << "c assumptions:";
+    for (int i = 0; i < assumptions.size(); ++i)
+    {
+        file << " " << SatSolver::toDimacs(assumptions[i]);
+    }
+    file << " 0\n";
+
+    DimacsWriter writer(file, s.nVars(), s.recorded().size() + assumptions.size());
+    s.recorded().replay(writer);
+    for (int i = 0; i < assumptions.size(); ++i)
+    {
+        writer.addClause(assumptions[i]);
+    }
+
+    return static_cast<bool>(file);
+}
+
+
+// the model satisfies the recorded formula and the assumptions
+bool checkModel(const SatSolver& s, const Minisat::vec<Minisat::Lit>& assumptions)
+{
+    const auto isTrue = [&](Minisat::Lit lit) { return Minisat::toInt(s.modelValue(lit)) == 0 /* = Minisat::l_True */; };
+
+    const ClauseBuffer& formula = s.recorded();
+    for (int c = 0; c < formula.size(); ++c)
+    {
+        bool satisfied = false;
+        for (int i = 0; i < formula.clauseSize(c) && !satisfied; ++i)
+        {
+            satisfied = isTrue(formula.clause(c)[i]);
+        }
+        if (!satisfied) return false;
+    }
+    for (int i = 0; i < assumptions.size(); ++i)
+    {
+        if (!isTrue(assumptions[i])) return false;
+    }
+    return true;
+}
+
+
+bool importCore(const std::string& fileName, SatSolver& s, const Minisat::vec<Minisat::Lit>& assumptions, std::ostream& log)
+{
+    std::ifstream file(fileName);
+    if (!file)
+    {
+        return false;
+    }
+
+    std::set<int> assumed;
+    for (int i = 0; i < assumptions.size(); ++i)
+    {
+        assumed.insert(SatSolver::toDimacs(assumptions[i]));
+    }
+
+    Minisat::vec<Minisat::Lit> conflict;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (line.empty() || line[0] == 'c') continue;
+        std::istringstream is(line);
+        int lit = 0;
+        while (is >> lit)
+        {
+            if (lit == 0) continue;
+            if (assumed.find(lit) == assumed.end())
+            {
+                log << "Error: core '" << fileName << "' contains " << lit << ", which is not an assumption of the query" << std::endl;
+                return false;
+            }
+            // the solver's final conflict consists of the negated assumptions
+            conflict.push(~SatSolver::fromDimacs(lit));
+        }
+    }
+
+    conflict.copyTo(s.conflict);
+    return true;
+}
+
+
+bool importModel(const std::string& fileName, SatSolver& s, const Minisat::vec<Minisat::Lit>& assumptions, bool& satisfiable, std::ostream& log)
+{
+    std::ifstream file(fileName);
+    if (!file)
+    {
+        return false;
+    }
+
+    bool status = false;
+    s.model.clear();
+    s.model.growTo(s.nVars(), l_False);
+
+    std::string token;
+    while (file >> token)
+    {
+        if (token == "c")
+        {
+            std::getline(file, token);
+        }
+        else if (token == "SATISFIABLE" || token == "SAT")
+        {
+            status = true;
+            satisfiable = true;
+        }
+        else if (token == "UNSATISFIABLE" || token == "UNSAT")
+        {
+            status = true;
+            satisfiable = false;
+        }
+        else if (token != "s" && token != "v")
+        {
+            const int lit = std::atoi(token.c_str());
+            if (lit != 0 && std::abs(lit) <= s.nVars())
+            {
+                s.model[std::abs(lit) - 1] = (lit > 0) ? l_True : l_False;
+            }
+        }
+    }
+
+    if (!status)
+    {
+        log << "Error: '" << fileName << "' does not state SATISFIABLE or UNSATISFIABLE" << std::endl;
+        return false;
+    }
+
+    if (!satisfiable)
+    {
+        // without a core, all assumptions are to blame
+        s.conflict.clear();
+        for (int i = 0; i < assumptions.size(); ++i)
+        {
+            s.conflict.push(~assumptions[i]);
+        }
+        return true;
+    }
+
+    if (!checkModel(s, assumptions))
+    {
+        log << "Error: the model in '" << fileName << "' does not satisfy the query" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+
+bool importAnswer(const std::string& name, SatSolver& s, const Minisat::vec<Minisat::Lit>& assumptions, bool& satisfiable, std::ostream& log)
+{
+    std::ifstream cnf(name + ".cnf");
+    const std::string expected = hashComment(queryHash(s, assumptions));
+    bool sameQuery = false;
+    std::string line;
+    while (!sameQuery && std::getline(cnf, line) && !line.empty() && line[0] == 'c')
+    {
+        sameQuery = (line == expected);
+    }
+    if (!sameQuery)
+    {
+        return false;
+    }
+
+    if (importCore(name + ".core", s, assumptions, log))
+    {
+        satisfiable = false;
+        return true;
+    }
+    return importModel(name + ".model", s, assumptions, satisfiable, log);
+}
+
+
+QuerySolver::QuerySolver(const DimacsOptions& options, const SolverOptions& solver, const std::string& source, std::ostream& log) :
+    m_options(options),
+    m_portfolio(std::max({solver.portfolio, solver.cubes, solver.speculate}),
+                (solver.cubes > 1) ? Portfolio::Mode::Cubes : (solver.portfolio > 1) ? Portfolio::Mode::Race : Portfolio::Mode::Alone),
+    m_source(source),
+    m_log(log)
+{}
+
+
+std::string QuerySolver::dump(const SatSolver& s, const Minisat::vec<Minisat::Lit>& assumptions, const std::string& stage)
+{
+    char number[16];
+    std::snprintf(number, sizeof(number), "%04d", m_queries++);
+    const std::string name = "-" + m_source + "-" + number + "-" + stage;
+
+    if (!m_options.dumpPrefix.empty())
+    {
+        writeDimacs(m_options.dumpPrefix + name + ".cnf", s, assumptions, "alcazar-gen query " + m_source + " " + number + " (" + stage + ")", m_log);
+    }
+    return name;
+}
+
+
+Minisat::lbool QuerySolver::solve(SatSolver& s, const FormulaLayout& layout, const Minisat::vec<Minisat::Lit>& assumptions, const std::string& stage)
+{
+    const std::string name = dump(s, assumptions, stage);
+
+    if (!m_options.importPrefix.empty())
+    {
+        bool satisfiable = false;
+        if (importAnswer(m_options.importPrefix + name, s, assumptions, satisfiable, m_log))
+        {
+            // a model of the edge encoding may contain disconnected cycles besides the path
+            if (!satisfiable || isPath(s, layout))
+            {
+                return Minisat::lbool(satisfiable);
+            }
+            m_log << "\nInfo: the external model of query " << name.substr(1) << " is not a single path, solving internally" << std::endl;
+        }
+    }
+
+    return m_portfolio.solve(s, layout, assumptions);
+}
+
+
+void QuerySolver::solveEach(SatSolver& s, const FormulaLayout& layout, const std::vector<std::vector<Minisat::Lit>>& queries, const std::string& stage,
+                            std::vector<Minisat::lbool>& results, std::vector<std::vector<Minisat::Lit>>& conflicts)
+{
+    if (!m_options.dumpPrefix.empty() || !m_options.importPrefix.empty())
+    {
+        Minisat::vec<Minisat::Lit> assumptions;
+        for (const auto& query: queries)
+        {
+            assumptions.clear();
+            for (auto lit: query)
+            {
+                assumptions.push(lit);
+            }
+            dump(s, assumptions, stage);
+        }
+    }
+    m_portfolio.solveEach(s, layout, queries, results, conflicts);
+}
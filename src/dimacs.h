@@ -0,0 +1,113 @@
+/*******************************************************************************
+* alcazar-gen
+*
+* Copyright (c) 2015 Florian Pigorsch
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <core/SolverTypes.h>
+
+#include "clauseSink.h"
+#include "formula.h"
+#include "portfolio.h"
+#include "satSolver.h"
+
+struct DimacsOptions
+{
+    // write every solver query to <dumpPrefix>-<source>-<number>-<stage>.cnf
+    std::string dumpPrefix;
+    // take the answers of an external solver from <importPrefix>-<source>-<number>-<stage>.core/.model
+    std::string importPrefix;
+};
+
+// Writes the clauses in DIMACS format. The header needs the numbers of variables and clauses up front
+// (e.g. from a ClauseBuffer or a CountingSink).
+class DimacsWriter : public ClauseSink
+{
+    public:
+        DimacsWriter(std::ostream& os, int vars, int clauses);
+
+        Minisat::Var newVar() override { return m_vars++; }
+        int nVars() const override { return m_vars; }
+
+    protected:
+        void addClause_(const Minisat::Lit* lits, int size) override;
+
+    private:
+        std::ostream& m_os;
+        int m_vars = 0;
+};
+
+// fingerprint of the recorded formula and the assumptions
+std::uint64_t queryHash(const SatSolver& s, const Minisat::vec<Minisat::Lit>& assumptions);
+
+// write the recorded formula and the assumptions (as unit clauses, and listed in a comment) in DIMACS format; errors go to the log
+bool writeDimacs(const std::string& fileName, const SatSolver& s, const Minisat::vec<Minisat::Lit>& assumptions, const std::string& comment,
+                 std::ostream& log);
+
+// Read an external solver's answer to a query. The answer is only used if <name>.cnf is the dump of the very same query.
+// - <name>.core: the assumptions (DIMACS literals) of an unsatisfiable core; sets s.conflict
+// - <name>.model: SAT competition output ("s SATISFIABLE", "v ..." lines) or Minisat's result file; sets s.model,
+//   or s.conflict to all assumptions if the answer is UNSAT
+// Returns false if there is no (valid) answer; an invalid one is reported to the log.
+bool importAnswer(const std::string& name, SatSolver& s, const Minisat::vec<Minisat::Lit>& assumptions, bool& satisfiable, std::ostream& log);
+
+// Runs the path queries of one source (generator, board) through solvePath (on a portfolio of solvers if configured),
+// dumping each query and using the answers of an external solver where available.
+class QuerySolver
+{
+    public:
+        // messages about dumped and imported queries go to the log
+        QuerySolver(const DimacsOptions& options, const SolverOptions& solver, const std::string& source, std::ostream& log);
+
+        // the queries need the solver to record the formula
+        bool needsRecording() const { return !m_options.dumpPrefix.empty() || !m_options.importPrefix.empty() || m_portfolio.size() > 1; }
+
+        // l_Undef if the query was interrupted
+        Minisat::lbool solve(SatSolver& s, const FormulaLayout& layout, const Minisat::vec<Minisat::Lit>& assumptions, const std::string& stage);
+
+        // different queries at once on the portfolio's members; they are dumped, but not imported
+        void solveEach(SatSolver& s, const FormulaLayout& layout, const std::vector<std::vector<Minisat::Lit>>& queries, const std::string& stage,
+                       std::vector<Minisat::lbool>& results, std::vector<std::vector<Minisat::Lit>>& conflicts);
+
+        // new dump/import prefixes; the query numbers start from 0 again
+        void setOptions(const DimacsOptions& options) { m_options = options; m_queries = 0; }
+
+        const Portfolio& portfolio() const { return m_portfolio; }
+        // interrupt the running query of the portfolio's copies (the caller interrupts the solver itself)
+        void interrupt() { m_portfolio.interrupt(); }
+
+    private:
+        // number the query and dump it if configured; returns the query's name suffix -<source>-<n>-<stage>
+        std::string dump(const SatSolver& s, const Minisat::vec<Minisat::Lit>& assumptions, const std::string& stage);
+
+        DimacsOptions m_options;
+        Portfolio m_portfolio;
+        std::string m_source;
+        std::ostream& m_log;
+        int m_queries = 0;
+};
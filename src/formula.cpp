@@ -22,14 +22,17 @@
 * SOFTWARE.
 *******************************************************************************/
 
+#include <algorithm>
+#include <cstdlib>
 #include <set>
 #include <vector>
 
-#include <core/Solver.h>
-#include <simp/SimpSolver.h>
-
+#include "cardinality.h"
+#include "clauseSink.h"
 #include "coordinates.h"
 #include "formula.h"
+#include "satSolver.h"
+#include "templateBoard.h"
 #include "wall.h"
 
 
@@ -45,29 +48,6 @@ Coordinates f2c(int f, int width)
 }
 
 
-std::vector<Wall> allWalls(int width, int height)
-{
-    std::vector<Wall> walls;
-
-    for (int y = 0; y < height; ++y)
-    {
-        for (int x = 0; x <= width; ++x)
-        {
-            walls.push_back(Wall({x, y}, Orientation::V));
-        }
-    }
-    for (int y = 0; y <= height; ++y)
-    {
-        for (int x = 0; x < width; ++x)
-        {
-            walls.push_back(Wall({x, y}, Orientation::H));
-        }
-    }
-
-    return walls;
-}
-
-
 std::vector<int> getEdgeFields(int width, int height)
 {
     std::vector<int> edgeFields;
@@ -85,6 +65,27 @@ std::vector<int> getEdgeFields(int width, int height)
 }
 
 
+// neighbouring field and the wall position in between
+struct Neighbour
+{
+    int field;
+    int wall;
+};
+
+
+// neighbours of a field in the order W, E, N, S; returns the number of neighbours
+int getNeighbours(int field, int width, int height, Neighbour* neighbours)
+{
+    const Coordinates c = f2c(field, width);
+    int count = 0;
+    if (c.x() > 0)          neighbours[count++] = {field - 1,     Wall(c, Orientation::V).id(width, height)};
+    if (c.x() + 1 < width)  neighbours[count++] = {field + 1,     Wall(c.offset(1, 0), Orientation::V).id(width, height)};
+    if (c.y() > 0)          neighbours[count++] = {field - width, Wall(c, Orientation::H).id(width, height)};
+    if (c.y() + 1 < height) neighbours[count++] = {field + width, Wall(c.offset(0, 1), Orientation::H).id(width, height)};
+    return count;
+}
+
+
 typedef Minisat::vec<Minisat::Lit> Clause;
 
 enum class Orientation2 {
@@ -98,133 +99,385 @@ enum class Orientation2 {
 };
 
 
-void buildFormula(int width, int height, SatSolver& s, std::map<std::pair<int, int>, Minisat::Lit>& fp2lit, std::map<Wall, Minisat::Lit>& w2lit)
+FormulaLayout::FormulaLayout(int width, int height, PathEncoding encoding) :
+    m_encoding(encoding),
+    m_width(width),
+    m_height(height),
+    m_wall(walls(), Minisat::lit_Undef),
+    m_edge(walls(), Minisat::lit_Undef)
 {
-    const int pathLength = width * height;
+    switch (encoding)
+    {
+        case PathEncoding::Position:
+            m_fp.assign(fields() * fields(), Minisat::lit_Undef);
+            break;
+        case PathEncoding::Edge:
+            m_end.assign(fields(), Minisat::lit_Undef);
+            break;
+        case PathEncoding::Binary:
+            m_succ.assign(4 * fields(), Minisat::lit_Undef);
+            m_first.assign(fields(), Minisat::lit_Undef);
+            m_last.assign(fields(), Minisat::lit_Undef);
+            break;
+    }
+}
 
-    std::map<std::pair<Coordinates, Orientation2>, Minisat::Lit> node2lit;
-    std::map<Wall, Minisat::Lit> edge2lit;
 
-    for (int field = 0; field < pathLength; ++field)
+void FormulaLayout::save(std::vector<Minisat::Lit>& lits) const
+{
+    lits.clear();
+    for (const std::vector<Minisat::Lit>* v : {&m_fp, &m_wall, &m_edge, &m_end, &m_bit, &m_succ, &m_first, &m_last})
+    {
+        lits.insert(lits.end(), v->begin(), v->end());
+    }
+}
+
+
+bool FormulaLayout::load(const Minisat::Lit* lits, int size)
+{
+    for (std::vector<Minisat::Lit>* v : {&m_fp, &m_wall, &m_edge, &m_end, &m_bit, &m_succ, &m_first, &m_last})
+    {
+        const int n = static_cast<int>(v->size());
+        if (n > size) return false;
+        std::copy(lits, lits + n, v->begin());
+        lits += n;
+        size -= n;
+    }
+    return size == 0;
+}
+
+
+Minisat::Lit FormulaLayout::entryLit(int field) const
+{
+    switch (m_encoding)
+    {
+        case PathEncoding::Position: return fp(field, 0);
+        case PathEncoding::Edge:     return end(field);
+        case PathEncoding::Binary:   return first(field);
+    }
+    return Minisat::lit_Undef;
+}
+
+
+Minisat::Lit FormulaLayout::exitLit(int field) const
+{
+    switch (m_encoding)
+    {
+        case PathEncoding::Position: return fp(field, fields() - 1);
+        case PathEncoding::Edge:     return end(field);
+        case PathEncoding::Binary:   return last(field);
+    }
+    return Minisat::lit_Undef;
+}
+
+
+bool parsePathEncoding(const std::string& name, PathEncoding& encoding)
+{
+    if (name == "position") { encoding = PathEncoding::Position; return true; }
+    if (name == "edge")     { encoding = PathEncoding::Edge;     return true; }
+    if (name == "binary")   { encoding = PathEncoding::Binary;   return true; }
+    return false;
+}
+
+
+std::string toString(PathEncoding encoding)
+{
+    switch (encoding)
+    {
+        case PathEncoding::Position: return "position";
+        case PathEncoding::Edge:     return "edge";
+        case PathEncoding::Binary:   return "binary";
+    }
+    return "?";
+}
+
+
+void addPositionEncoding(int width, int height, const FormulaOptions& options, ClauseSink& s, FormulaLayout& layout, FormulaStats& stats);
+void addEdgeEncoding(int width, int height, ClauseSink& s, FormulaLayout& layout);
+void addBinaryEncoding(int width, int height, const FormulaOptions& options, ClauseSink& s, FormulaLayout& layout);
+void addEntryExit(int width, int height, ClauseSink& s, const FormulaLayout& layout);
+void addNodeStructure(int width, int height, ClauseSink& s, const FormulaLayout& layout);
+void addEdgeEscape(int width, int height, ClauseSink& s, const FormulaLayout& layout);
+void addBoundaryParity(int width, int height, ClauseSink& s, const FormulaLayout& layout);
+
+
+// On boards with an even number of fields, entry and exit have different colours (checkerboard);
+// the position encoding then breaks the direction symmetry by colour instead of by field index.
+bool entryByColour(const FormulaLayout& layout)
+{
+    return layout.encoding() == PathEncoding::Position && (layout.fields() % 2) == 0;
+}
+
+
+void orderEnds(const FormulaLayout& layout, int& entry, int& exit)
+{
+    const bool swap = entryByColour(layout)
+        ? ((layout.f2c(entry).x() + layout.f2c(entry).y()) % 2) != 0
+        : exit < entry;
+    if (swap)
+    {
+        std::swap(entry, exit);
+    }
+}
+
+
+// distance of every field to the nearest non-blocked edge field, not crossing fixed closed walls (-1: unreachable)
+std::vector<int> getEdgeDistances(const TemplateBoard& templateBoard)
+{
+    const int width = templateBoard.width();
+    const int height = templateBoard.height();
+
+    std::vector<bool> closed(Wall::count(width, height), false);
+    for (auto wall: templateBoard.getFixedClosedWalls())
     {
-        for (int pathpos = 0; pathpos < pathLength; ++pathpos)
+        closed[wall.id(width, height)] = true;
+    }
+
+    std::vector<int> distance(width * height, -1);
+    std::vector<int> queue;
+    for (auto c: templateBoard.getNonBlockedEdgeFields())
+    {
+        const int field = c2f(c, width);
+        if (distance[field] < 0)
         {
-            fp2lit[{field, pathpos}] = Minisat::mkLit(s.newVar());
+            distance[field] = 0;
+            queue.push_back(field);
         }
     }
 
-    for (auto wall: allWalls(width, height))
+    Neighbour neighbours[4];
+    for (unsigned int i = 0; i < queue.size(); ++i)
     {
-        w2lit[wall] = Minisat::mkLit(s.newVar());
-        edge2lit[wall] = Minisat::mkLit(s.newVar());
-        s.addClause(~w2lit[wall], edge2lit[wall]);
+        const int field = queue[i];
+        const int count = getNeighbours(field, width, height, neighbours);
+        for (int n = 0; n < count; ++n)
+        {
+            if (closed[neighbours[n].wall] || distance[neighbours[n].field] >= 0) continue;
+            distance[neighbours[n].field] = distance[field] + 1;
+            queue.push_back(neighbours[n].field);
+        }
     }
 
-    std::set<Coordinates> allCoordinates;
-    for (int x = 0; x < width; ++x)
+    return distance;
+}
+
+
+FormulaStats buildFormula(const TemplateBoard& templateBoard, const FormulaOptions& options, ClauseSink& sink, FormulaLayout& layout)
+{
+    // the template's fixed walls are constants: they share one literal that is true, and the clauses are folded on it
+    FoldingSink s(sink);
+    const int width = templateBoard.width();
+    const int height = templateBoard.height();
+    const int pathLength = width * height;
+
+    layout = FormulaLayout(width, height, options.pathEncoding);
+
+    FormulaStats stats;
+    if (options.pathEncoding == PathEncoding::Position)
     {
-        for (int y = 0; y < height; ++y)
+        // presolve: field f can only be at position p if
+        // - p has f's colour: the path alternates colours, and the entry is white (odd boards: white is the
+        //   majority colour, so both ends are white; even boards: see entryByColour)
+        // - f is reachable from an entry within p steps and from an exit within P-1-p steps
+        const std::vector<int> distance = getEdgeDistances(templateBoard);
+        for (int field = 0; field < pathLength; ++field)
         {
-            allCoordinates.insert({x, y});
+            const Coordinates c = f2c(field, width);
+            for (int pathpos = 0; pathpos < pathLength; ++pathpos)
+            {
+                const bool colour = ((c.x() + c.y() + pathpos) % 2) == 0;
+                const bool reachable = distance[field] >= 0 && distance[field] <= pathpos && distance[field] <= pathLength - 1 - pathpos;
+                if (colour && reachable)
+                {
+                    layout.fp(field, pathpos) = Minisat::mkLit(s.newVar());
+                }
+                else
+                {
+                    ++stats.prunedVariables;
+                }
+            }
         }
     }
 
-    std::set<Coordinates> nodeCoordinates;
-    for (int x = 0; x < width; ++x)
+    const std::set<Wall>& fixedClosedWalls = templateBoard.getFixedClosedWalls();
+    const std::set<Wall>& fixedOpenWalls = templateBoard.getFixedOpenWalls();
+    for (int wall = 0; wall < layout.walls(); ++wall)
     {
-        for (int y = 0; y < height; ++y)
+        const Wall w = Wall::fromId(wall, width, height);
+        if (fixedClosedWalls.find(w) != fixedClosedWalls.end())
         {
-            nodeCoordinates.insert({x, y});
-            node2lit[{{x, y}, Orientation2::NW}] = Minisat::mkLit(s.newVar());
-            node2lit[{{x, y}, Orientation2::NE}] = Minisat::mkLit(s.newVar());
+            // the path cannot cross a fixed closed wall
+            layout.wall(wall) = s.constant();
+            layout.edge(wall) = s.constant();
+            continue;
         }
+        layout.wall(wall) = (fixedOpenWalls.find(w) != fixedOpenWalls.end()) ? ~s.constant() : Minisat::mkLit(s.newVar());
+        layout.edge(wall) = Minisat::mkLit(s.newVar());
+        s.addClause(~layout.wall(wall), layout.edge(wall));
     }
+    const auto edge2lit = [&](const Wall& wall) { return layout.edge(wall); };
 
     // Each coordinate has exactly 2 walls and 2 open
-    for (auto c: allCoordinates) {
-        const auto walln = edge2lit[Wall(c, Orientation::H)];
-        const auto wallw = edge2lit[Wall(c, Orientation::V)];
-        const auto walls = edge2lit[Wall(c.offset(0, 1), Orientation::H)];
-        const auto walle = edge2lit[Wall(c.offset(1, 0), Orientation::V)];
+    for (int x = 0; x < width; ++x)
+    {
+        for (int y = 0; y < height; ++y)
+        {
+            const Coordinates c(x, y);
+            const auto walln = edge2lit(Wall(c, Orientation::H));
+            const auto wallw = edge2lit(Wall(c, Orientation::V));
+            const auto walls = edge2lit(Wall(c.offset(0, 1), Orientation::H));
+            const auto walle = edge2lit(Wall(c.offset(1, 0), Orientation::V));
 
-        // Each coordinate has at least 2 open
-        s.addClause(~walln, ~walle, ~walls);
-        s.addClause(~walln, ~walle, ~wallw);
-        s.addClause(~walln, ~walls, ~wallw);
-        s.addClause(~walle, ~walls, ~wallw);
+            // Each coordinate has at least 2 open
+            s.addClause(~walln, ~walle, ~walls);
+            s.addClause(~walln, ~walle, ~wallw);
+            s.addClause(~walln, ~walls, ~wallw);
+            s.addClause(~walle, ~walls, ~wallw);
 
-        // Each coordinate has at least 2 walls
-        s.addClause(walln, walle, walls);
-        s.addClause(walln, walle, wallw);
-        s.addClause(walln, walls, wallw);
-        s.addClause(walle, walls, wallw);
+            // Each coordinate has at least 2 walls
+            s.addClause(walln, walle, walls);
+            s.addClause(walln, walle, wallw);
+            s.addClause(walln, walls, wallw);
+            s.addClause(walle, walls, wallw);
+        }
     }
 
     // corners must have at least one wall
     // top left
     {
-        const auto wall1 = edge2lit[Wall({0, 0}, Orientation::H)];
-        const auto wall2 = edge2lit[Wall({0, 0}, Orientation::V)];
+        const auto wall1 = edge2lit(Wall({0, 0}, Orientation::H));
+        const auto wall2 = edge2lit(Wall({0, 0}, Orientation::V));
         s.addClause(wall1, wall2);
     }
     // top right
     {
-        const auto wall1 = edge2lit[Wall({width-1, 0}, Orientation::H)];
-        const auto wall2 = edge2lit[Wall({width, 0}, Orientation::V)];
+        const auto wall1 = edge2lit(Wall({width-1, 0}, Orientation::H));
+        const auto wall2 = edge2lit(Wall({width, 0}, Orientation::V));
         s.addClause(wall1, wall2);
     }
     // bottom left
     {
-        const auto wall1 = edge2lit[Wall({0, height}, Orientation::H)];
-        const auto wall2 = edge2lit[Wall({0, height-1}, Orientation::V)];
+        const auto wall1 = edge2lit(Wall({0, height}, Orientation::H));
+        const auto wall2 = edge2lit(Wall({0, height-1}, Orientation::V));
         s.addClause(wall1, wall2);
     }
     // bottom right
     {
-        const auto wall1 = edge2lit[Wall({width-1, height}, Orientation::H)];
-        const auto wall2 = edge2lit[Wall({width, height-1}, Orientation::V)];
+        const auto wall1 = edge2lit(Wall({width-1, height}, Orientation::H));
+        const auto wall2 = edge2lit(Wall({width, height-1}, Orientation::V));
         s.addClause(wall1, wall2);
     }
 
-    for (auto nc: nodeCoordinates)
+    if (options.nodeStructure)
+    {
+        addNodeStructure(width, height, s, layout);
+    }
+
+    switch (options.pathEncoding)
+    {
+        case PathEncoding::Position:
+            addPositionEncoding(width, height, options, s, layout, stats);
+            break;
+        case PathEncoding::Edge:
+            addEdgeEncoding(width, height, s, layout);
+            break;
+        case PathEncoding::Binary:
+            addBinaryEncoding(width, height, options, s, layout);
+            break;
+    }
+
+    // the edge encoding already contains the edge escape rules
+    if (options.edgeEscape && options.pathEncoding != PathEncoding::Edge)
+    {
+        addEdgeEscape(width, height, s, layout);
+    }
+    if (options.boundaryParity)
+    {
+        addBoundaryParity(width, height, s, layout);
+    }
+    stats.foldedClauses = s.nFolded();
+    return stats;
+}
+
+
+// Redundant node structure: every node (lower right corner of a field) is oriented along one of its crossed wall
+// positions (see Orientation2).
+void addNodeStructure(int width, int height, ClauseSink& s, const FormulaLayout& layout)
+{
+    const auto edge2lit = [&](const Wall& wall) { return layout.edge(wall); };
+
+    // nodes at the lower right corner of each field, indexed by (x * height + y) * 2 + orientation
+    std::vector<Minisat::Lit> nodes(2 * width * height);
+    for (int x = 0; x < width; ++x)
+    {
+        for (int y = 0; y < height; ++y)
+        {
+            nodes[(x * height + y) * 2 + 0] = Minisat::mkLit(s.newVar());
+            nodes[(x * height + y) * 2 + 1] = Minisat::mkLit(s.newVar());
+        }
+    }
+    const auto node2lit = [&](int x, int y, Orientation2 o) { return nodes[(x * height + y) * 2 + (o == Orientation2::NE ? 1 : 0)]; };
+
+    for (int x = 0; x < width; ++x)
     {
-        const auto nw = node2lit[{nc, Orientation2::NW}];
-        const auto ne = node2lit[{nc, Orientation2::NE}];
-        const auto sw = ~node2lit[{nc, Orientation2::NE}];
-        const auto se = ~node2lit[{nc, Orientation2::NW}];
-        const auto walln = edge2lit[Wall(nc.offset(1, 0), Orientation::V)];
-        const auto wallw = edge2lit[Wall(nc.offset(0, 1), Orientation::H)];
-        const auto walle = edge2lit[Wall(nc.offset(1, 1), Orientation::H)];
-        const auto walls = edge2lit[Wall(nc.offset(1, 1), Orientation::V)];
+        for (int y = 0; y < height; ++y)
+        {
+            const Coordinates nc(x, y);
+            const auto nw = node2lit(x, y, Orientation2::NW);
+            const auto ne = node2lit(x, y, Orientation2::NE);
+            const auto sw = ~node2lit(x, y, Orientation2::NE);
+            const auto se = ~node2lit(x, y, Orientation2::NW);
+            const auto walln = edge2lit(Wall(nc.offset(1, 0), Orientation::V));
+            const auto wallw = edge2lit(Wall(nc.offset(0, 1), Orientation::H));
 
-        // every node must be oriented along a wall
-        s.addClause(~nw, ~ne, walln);
-        s.addClause(~sw, ~se, walls);
-        s.addClause(~ne, ~se, walle);
-        s.addClause(~nw, ~sw, wallw);
+            // every node must be oriented along a wall
+            s.addClause(~nw, ~ne, walln);
+            s.addClause(~nw, ~sw, wallw);
 
-        // every node must be away from a corner
-        s.addClause(walln, walle, ~ne);
-        s.addClause(walls, walle, ~se);
-        s.addClause(walln, wallw, ~nw);
-        s.addClause(walls, wallw, ~sw);
+            // every node must be away from a corner
+            s.addClause(walln, wallw, ~nw);
+
+            // wall positions outside of the board are never crossed, i.e. clauses containing them are satisfied
+            const bool hasWalle = nc.x() + 1 < width;
+            const bool hasWalls = nc.y() + 1 < height;
+            if (hasWalle)
+            {
+                const auto walle = edge2lit(Wall(nc.offset(1, 1), Orientation::H));
+                s.addClause(~ne, ~se, walle);
+                s.addClause(walln, walle, ~ne);
+            }
+            if (hasWalls)
+            {
+                const auto walls = edge2lit(Wall(nc.offset(1, 1), Orientation::V));
+                s.addClause(~sw, ~se, walls);
+                s.addClause(walls, wallw, ~sw);
+            }
+            if (hasWalle && hasWalls)
+            {
+                const auto walle = edge2lit(Wall(nc.offset(1, 1), Orientation::H));
+                const auto walls = edge2lit(Wall(nc.offset(1, 1), Orientation::V));
+                s.addClause(walls, walle, ~se);
+            }
+        }
     }
 
+    Clause clause;
+
     // every horizontal non-border wall
     for (int y = 1; y <= height - 1; ++y)
     {
         for (int x = 1; x < width - 1; ++x)
         {
-            const auto wall  = edge2lit[Wall({x, y  }, Orientation::H)];
-            const auto walln = edge2lit[Wall({x, y-1}, Orientation::H)];
-            const auto walls = edge2lit[Wall({x, y+1}, Orientation::H)];
-            const auto nodew_ne =  node2lit[{{x-1, y-1}, Orientation2::NE}];
-            const auto nodew_se = ~node2lit[{{x-1, y-1}, Orientation2::NW}];
-            const auto nodee_nw =  node2lit[{{x, y-1}, Orientation2::NW}];
-            const auto nodee_sw = ~node2lit[{{x, y-1}, Orientation2::NE}];
+            const auto wall  = edge2lit(Wall({x, y  }, Orientation::H));
+            const auto walln = edge2lit(Wall({x, y-1}, Orientation::H));
+            const auto walls = edge2lit(Wall({x, y+1}, Orientation::H));
+            const auto nodew_ne =  node2lit(x-1, y-1, Orientation2::NE);
+            const auto nodew_se = ~node2lit(x-1, y-1, Orientation2::NW);
+            const auto nodee_nw =  node2lit(x, y-1, Orientation2::NW);
+            const auto nodee_sw = ~node2lit(x, y-1, Orientation2::NE);
 
             // nodes don't orient toward eachother
-            { Clause c; c.push(~nodew_ne); c.push(~nodew_se); c.push(~nodee_nw); c.push(~nodee_sw); s.addClause(c); }
+            clause.clear(); clause.push(~nodew_ne); clause.push(~nodew_se); clause.push(~nodee_nw); clause.push(~nodee_sw); s.addClause(clause);
 
             // at least one opposing node points away from every wall
             s.addClause(~nodew_ne, ~nodee_nw, ~walln);
@@ -243,16 +496,16 @@ void buildFormula(int width, int height, SatSolver& s, std::map<std::pair<int, i
     {
         for (int x = 1; x <= width - 1; ++x)
         {
-            const auto wall  = edge2lit[Wall({x,   y}, Orientation::V)];
-            const auto wallw = edge2lit[Wall({x-1, y}, Orientation::V)];
-            const auto walle = edge2lit[Wall({x+1, y}, Orientation::V)];
-            const auto noden_se = ~node2lit[{{x-1, y-1}, Orientation2::NW}];
-            const auto noden_sw = ~node2lit[{{x-1, y-1}, Orientation2::NE}];
-            const auto nodes_ne =  node2lit[{{x-1, y}, Orientation2::NE}];
-            const auto nodes_nw =  node2lit[{{x-1, y}, Orientation2::NW}];
+            const auto wall  = edge2lit(Wall({x,   y}, Orientation::V));
+            const auto wallw = edge2lit(Wall({x-1, y}, Orientation::V));
+            const auto walle = edge2lit(Wall({x+1, y}, Orientation::V));
+            const auto noden_se = ~node2lit(x-1, y-1, Orientation2::NW);
+            const auto noden_sw = ~node2lit(x-1, y-1, Orientation2::NE);
+            const auto nodes_ne =  node2lit(x-1, y, Orientation2::NE);
+            const auto nodes_nw =  node2lit(x-1, y, Orientation2::NW);
 
             // nodes don't orient toward eachother
-            { Clause c; c.push(~noden_se); c.push(~noden_sw); c.push(~nodes_ne); c.push(~nodes_nw); s.addClause(c); }
+            clause.clear(); clause.push(~noden_se); clause.push(~noden_sw); clause.push(~nodes_ne); clause.push(~nodes_nw); s.addClause(clause);
 
             // at least one opposing node points away from every wall
             s.addClause(~noden_se, ~nodes_ne, ~walle);
@@ -271,157 +524,132 @@ void buildFormula(int width, int height, SatSolver& s, std::map<std::pair<int, i
     {
         for (int x = 1; x < width - 1; ++x)
         {
-            const auto a = ~node2lit[{{x,   y  }, Orientation2::NW}];
-            const auto b =  node2lit[{{x,   y+1}, Orientation2::NE}];
-            const auto c = ~node2lit[{{x+1, y  }, Orientation2::NE}];
-            const auto d =  node2lit[{{x+1, y+1}, Orientation2::NW}];
+            const auto a = ~node2lit(x,   y,   Orientation2::NW);
+            const auto b =  node2lit(x,   y+1, Orientation2::NE);
+            const auto c = ~node2lit(x+1, y,   Orientation2::NE);
+            const auto d =  node2lit(x+1, y+1, Orientation2::NW);
             s.addClause(~a, ~b, ~c);
             s.addClause(~a, ~b, ~d);
             s.addClause(~a, ~c, ~d);
             s.addClause(~b, ~c, ~d);
         }
     }
+}
 
-    // TODO edge escape rules
-    // TODO 2 edge boundaries (with parity)
+void addPositionEncoding(int width, int height, const FormulaOptions& options, ClauseSink& s, FormulaLayout& layout, FormulaStats& stats)
+{
+    const int pathLength = width * height;
+
+    const int cardinalityVars = s.nVars();
+    const int cardinalityClauses = s.nClauses();
+
+    // pruned (field, position) pairs have no variable and are left out of all clauses
+    const auto exists = [&](int field, int pos) { return layout.fp(field, pos) != Minisat::lit_Undef; };
 
-    // every field must appear on the path
-    // (f@0 + f@1 + ... + f@P-1) for all f
+    std::vector<Minisat::Lit> lits;
+    lits.reserve(pathLength);
+
+    // every field must appear exactly once on the path
+    // (f@0 + f@1 + ... + f@P-1) and f@i -> ~f@j for all f for all i!=j
     for (int field = 0; field < pathLength; ++field)
     {
-        Clause clause;
+        lits.clear();
         for (int pos = 0; pos < pathLength; ++pos)
         {
-            const auto lit = fp2lit[{field, pos}];
-            clause.push(lit);
+            if (exists(field, pos)) lits.push_back(layout.fp(field, pos));
         }
-        s.addClause(clause);
+        addExactlyOne(s, lits, options.fieldAmo);
     }
 
-    // every field must not appear twice on the path
-    // f@i -> ~f@j for all f for all i!=j
-    for (int field = 0; field < pathLength; ++field)
-    {
-        for (int pos1 = 0; pos1 < pathLength; ++pos1)
-        {
-            for (int pos2 = pos1+1; pos2 < pathLength; ++pos2)
-            {
-                const auto lit1 = fp2lit[{field, pos1}];
-                const auto lit2 = fp2lit[{field, pos2}];
-                s.addClause(~lit1, ~lit2);
-            }
-        }
-    }
-
-    // some field must be the path's ith step
-    // (0@p + 1@p + ... + F-1@p) for all p
+    // exactly one field must be the path's ith step
+    // (0@p + 1@p + ... + F-1@p) and i@p -> ~j@p for all p for all i!=j
     for (int pos = 0; pos < pathLength; ++pos)
     {
-        Clause clause;
+        lits.clear();
         for (int field = 0; field < pathLength; ++field)
         {
-            const auto lit = fp2lit[{field, pos}];
-            clause.push(lit);
+            if (exists(field, pos)) lits.push_back(layout.fp(field, pos));
         }
-        s.addClause(clause);
+        addExactlyOne(s, lits, options.positionAmo);
     }
 
-    // two fields must not be the path's ith step at the same time
-    // i@p -> ~j@p for all p for all i!=j
-    for (int pos = 0; pos < pathLength; ++pos)
-    {
-        for (int field1 = 0; field1 < pathLength; ++field1)
-        {
-            for (int field2 = field1+1; field2 < pathLength; ++field2)
-            {
-                const auto lit1 = fp2lit[{field1, pos}];
-                const auto lit2 = fp2lit[{field2, pos}];
-                s.addClause(~lit1, ~lit2);
-            }
-        }
-    }
+    stats.cardinalityVariables = s.nVars() - cardinalityVars;
+    stats.cardinalityClauses = s.nClauses() - cardinalityClauses;
 
     // consecutive path positions only between neighbours
-    for (auto c: allCoordinates)
+    Clause clause;
+    Neighbour neighbours[4];
+    for (int x = 0; x < width; ++x)
     {
-        std::vector<Coordinates> neighbours;
-        std::set<Coordinates> nonNeighbours = allCoordinates;
-        nonNeighbours.erase(c);
-        if (c.x() > 0)          { neighbours.push_back(c.offset(-1,0)); nonNeighbours.erase(c.offset(-1,0)); }
-        if (c.x() + 1 < width)  { neighbours.push_back(c.offset(+1,0)); nonNeighbours.erase(c.offset(+1,0)); }
-        if (c.y() > 0)          { neighbours.push_back(c.offset(0,-1)); nonNeighbours.erase(c.offset(0,-1)); }
-        if (c.y() + 1 < height) { neighbours.push_back(c.offset(0,+1)); nonNeighbours.erase(c.offset(0,+1)); }
-
-        const int field = c2f(c, width);
-        for (int p = 0; p+1 < pathLength; ++p)
+        for (int y = 0; y < height; ++y)
         {
-            // f@p -> fn@p+1 v fe@p+1 v fs@p+1 v fw@p+1
-            Clause clause;
-            clause.push(~fp2lit[{field, p}]);
-            for (auto n: neighbours) { clause.push(fp2lit[{c2f(n, width), p+1}]); }
-            s.addClause(clause);
+            const int field = c2f({x, y}, width);
+            const int count = getNeighbours(field, width, height, neighbours);
 
-            // f@p+1 -> fn@p v fe@p v fs@p v fw@p
-            Clause clause2;
-            clause2.push(~fp2lit[{field, p+1}]);
-            for (auto n: neighbours) { clause2.push(fp2lit[{c2f(n, width), p}]); }
-            s.addClause(clause2);
-
-            // f@p -> ~g@p for all non-neighbours g of f
-            for (auto n: nonNeighbours)
+            for (int p = 0; p+1 < pathLength; ++p)
             {
-                s.addClause(~fp2lit[{field, p}], ~fp2lit[{c2f(n, width), p+1}]);
+                // f@p -> fn@p+1 v fe@p+1 v fs@p+1 v fw@p+1
+                if (exists(field, p))
+                {
+                    clause.clear();
+                    clause.push(~layout.fp(field, p));
+                    for (int i = 0; i < count; ++i) { if (exists(neighbours[i].field, p+1)) clause.push(layout.fp(neighbours[i].field, p+1)); }
+                    s.addClause(clause);
+                }
+
+                // f@p+1 -> fn@p v fe@p v fs@p v fw@p
+                if (exists(field, p+1))
+                {
+                    clause.clear();
+                    clause.push(~layout.fp(field, p+1));
+                    for (int i = 0; i < count; ++i) { if (exists(neighbours[i].field, p)) clause.push(layout.fp(neighbours[i].field, p)); }
+                    s.addClause(clause);
+                }
+
+                // f@p -> ~g@p+1 for all non-neighbours g of f (redundant: implied by the neighbour and exactly-one clauses)
+                if (!options.nonNeighbours || !exists(field, p)) continue;
+                for (int gx = 0; gx < width; ++gx)
+                {
+                    for (int gy = 0; gy < height; ++gy)
+                    {
+                        const int other = c2f({gx, gy}, width);
+                        if (std::abs(gx - x) + std::abs(gy - y) <= 1 || !exists(other, p+1)) continue;
+                        s.addClause(~layout.fp(field, p), ~layout.fp(other, p+1));
+                    }
+                }
             }
         }
     }
 
     // no consecutive path positions between fields separated by wall
     // wall(f1, f2) -> (!f1@p + !f2@p+1) <=> (!wall(f1, f2) + !f1@p + !f2@p+1)
-    for (auto c: allCoordinates)
+    for (int x = 0; x < width; ++x)
     {
-        const int field = c2f(c, width);
-        for (int p = 0; p+1 < pathLength; ++p)
+        for (int y = 0; y < height; ++y)
         {
-            const auto lit1 = fp2lit[{field, p}];
-
-            // left wall
-            if (c.x() > 0)
+            const int field = c2f({x, y}, width);
+            const int count = getNeighbours(field, width, height, neighbours);
+            for (int p = 0; p+1 < pathLength; ++p)
             {
-                const Wall w(c, Orientation::V);
-                const auto litw = w2lit[w];
-                const auto lit2 = fp2lit[{c2f(c.offset(-1,0), width), p+1}];
-                s.addClause(~litw, ~lit1, ~lit2);
-            }
-
-            // right wall
-            if (c.x() + 1 < width)
-            {
-                const Wall w(c.offset(+1,0), Orientation::V);
-                const auto litw = w2lit[w];
-                const auto lit2 = fp2lit[{c2f(c.offset(+1,0), width), p+1}];
-                s.addClause(~litw, ~lit1, ~lit2);
-            }
-
-            // top wall
-            if (c.y() > 0)
-            {
-                const Wall w(c, Orientation::H);
-                const auto litw = w2lit[w];
-                const auto lit2 = fp2lit[{c2f(c.offset(0,-1), width), p+1}];
-                s.addClause(~litw, ~lit1, ~lit2);
-            }
-
-            // bottom wall
-            if (c.y() + 1 < height)
-            {
-                const Wall w(c.offset(0,+1), Orientation::H);
-                const auto litw = w2lit[w];
-                const auto lit2 = fp2lit[{c2f(c.offset(0,+1), width), p+1}];
-                s.addClause(~litw, ~lit1, ~lit2);
+                if (!exists(field, p)) continue;
+                const auto lit1 = layout.fp(field, p);
+                for (int i = 0; i < count; ++i)
+                {
+                    if (!exists(neighbours[i].field, p+1)) continue;
+                    const auto litw = layout.wall(neighbours[i].wall);
+                    const auto lit2 = layout.fp(neighbours[i].field, p+1);
+                    s.addClause(~litw, ~lit1, ~lit2);
+                }
             }
         }
     }
 
+    addEntryExit(width, height, s, layout);
+}
+
+
+void addEntryExit(int width, int height, ClauseSink& s, const FormulaLayout& layout)
+{
     // path must start/end at edge
     const std::vector<int> edgeFields = getEdgeFields(width, height);
 
@@ -429,21 +657,23 @@ void buildFormula(int width, int height, SatSolver& s, std::map<std::pair<int, i
     Clause exitClause;
     for (auto field: edgeFields)
     {
-        entryClause.push(fp2lit[{field, 0}]);
-        exitClause.push(fp2lit[{field, pathLength-1}]);
+        // literals of pruned (impossible) entries/exits are undefined
+        if (layout.entryLit(field) != Minisat::lit_Undef) entryClause.push(layout.entryLit(field));
+        if (layout.exitLit(field) != Minisat::lit_Undef) exitClause.push(layout.exitLit(field));
     }
     s.addClause(entryClause);
     s.addClause(exitClause);
 
-    // avoid symmetry -> enforce: entry < exit
+    // avoid symmetry -> enforce: entry < exit (unless already broken by colour)
     for (auto field1: edgeFields)
     {
         for (auto field2: edgeFields)
         {
-            if (field2 < field1)
+            if (field2 < field1 && !entryByColour(layout))
             {
-                const auto lit1 = fp2lit[{field1, 0}];
-                const auto lit2 = fp2lit[{field2, pathLength-1}];
+                const auto lit1 = layout.entryLit(field1);
+                const auto lit2 = layout.exitLit(field2);
+                if (lit1 == Minisat::lit_Undef || lit2 == Minisat::lit_Undef) continue;
                 s.addClause(~lit1, ~lit2);
             }
         }
@@ -451,89 +681,568 @@ void buildFormula(int width, int height, SatSolver& s, std::map<std::pair<int, i
 
     // walls can block entry/exit fields
     // top/bottom edge
-    for (int x = 1; x < width-2; ++x)
+    for (int x = 1; x < width-1; ++x)
     {
         {
-            const Wall w({x, 0}, Orientation::H);
-            const auto litw = w2lit[w];
-            const auto lit1 = fp2lit[{c2f({x, 0}, width), 0}];
-            const auto lit2 = fp2lit[{c2f({x, 0}, width), pathLength-1}];
-            s.addClause(~litw, ~lit1);
-            s.addClause(~litw, ~lit2);
+            const auto litw = layout.wall(Wall({x, 0}, Orientation::H));
+            const auto lit1 = layout.entryLit(c2f({x, 0}, width));
+            const auto lit2 = layout.exitLit(c2f({x, 0}, width));
+            if (lit1 != Minisat::lit_Undef) s.addClause(~litw, ~lit1);
+            if (lit2 != Minisat::lit_Undef) s.addClause(~litw, ~lit2);
         }
 
         {
-            const Wall w({x, height}, Orientation::H);
-            const auto litw = w2lit[w];
-            const auto lit1 = fp2lit[{c2f({x, height-1}, width), 0}];
-            const auto lit2 = fp2lit[{c2f({x, height-1}, width), pathLength-1}];
-            s.addClause(~litw, ~lit1);
-            s.addClause(~litw, ~lit2);
+            const auto litw = layout.wall(Wall({x, height}, Orientation::H));
+            const auto lit1 = layout.entryLit(c2f({x, height-1}, width));
+            const auto lit2 = layout.exitLit(c2f({x, height-1}, width));
+            if (lit1 != Minisat::lit_Undef) s.addClause(~litw, ~lit1);
+            if (lit2 != Minisat::lit_Undef) s.addClause(~litw, ~lit2);
         }
     }
     // left/right edge
-    for (int y = 1; y < height-2; ++y)
+    for (int y = 1; y < height-1; ++y)
     {
         {
-            const Wall w({0, y}, Orientation::V);
-            const auto litw = w2lit[w];
-            const auto lit1 = fp2lit[{c2f({0, y}, width), 0}];
-            const auto lit2 = fp2lit[{c2f({0, y}, width), pathLength-1}];
-            s.addClause(~litw, ~lit1);
-            s.addClause(~litw, ~lit2);
+            const auto litw = layout.wall(Wall({0, y}, Orientation::V));
+            const auto lit1 = layout.entryLit(c2f({0, y}, width));
+            const auto lit2 = layout.exitLit(c2f({0, y}, width));
+            if (lit1 != Minisat::lit_Undef) s.addClause(~litw, ~lit1);
+            if (lit2 != Minisat::lit_Undef) s.addClause(~litw, ~lit2);
         }
 
         {
-            const Wall w({width, y}, Orientation::V);
-            const auto litw = w2lit[w];
-            const auto lit1 = fp2lit[{c2f({width-1, y}, width), 0}];
-            const auto lit2 = fp2lit[{c2f({width-1, y}, width), pathLength-1}];
-            s.addClause(~litw, ~lit1);
-            s.addClause(~litw, ~lit2);
+            const auto litw = layout.wall(Wall({width, y}, Orientation::V));
+            const auto lit1 = layout.entryLit(c2f({width-1, y}, width));
+            const auto lit2 = layout.exitLit(c2f({width-1, y}, width));
+            if (lit1 != Minisat::lit_Undef) s.addClause(~litw, ~lit1);
+            if (lit2 != Minisat::lit_Undef) s.addClause(~litw, ~lit2);
         }
     }
     // top left corner
     {
-        const Wall w1({0, 0}, Orientation::V);
-        const Wall w2({0, 0}, Orientation::H);
-        const auto litw1 = w2lit[w1];
-        const auto litw2 = w2lit[w2];
-        const auto lit1 = fp2lit[{c2f({0, 0}, width), 0}];
-        const auto lit2 = fp2lit[{c2f({0, 0}, width), pathLength-1}];
-        s.addClause(~litw1, ~litw2, ~lit1);
-        s.addClause(~litw1, ~litw2, ~lit2);
+        const auto litw1 = layout.wall(Wall({0, 0}, Orientation::V));
+        const auto litw2 = layout.wall(Wall({0, 0}, Orientation::H));
+        const auto lit1 = layout.entryLit(c2f({0, 0}, width));
+        const auto lit2 = layout.exitLit(c2f({0, 0}, width));
+        if (lit1 != Minisat::lit_Undef) s.addClause(~litw1, ~litw2, ~lit1);
+        if (lit2 != Minisat::lit_Undef) s.addClause(~litw1, ~litw2, ~lit2);
     }
     // top right corner
     {
-        const Wall w1({width, 0}, Orientation::V);
-        const Wall w2({width-1, 0}, Orientation::H);
-        const auto litw1 = w2lit[w1];
-        const auto litw2 = w2lit[w2];
-        const auto lit1 = fp2lit[{c2f({width-1, 0}, width), 0}];
-        const auto lit2 = fp2lit[{c2f({width-1, 0}, width), pathLength-1}];
-        s.addClause(~litw1, ~litw2, ~lit1);
-        s.addClause(~litw1, ~litw2, ~lit2);
+        const auto litw1 = layout.wall(Wall({width, 0}, Orientation::V));
+        const auto litw2 = layout.wall(Wall({width-1, 0}, Orientation::H));
+        const auto lit1 = layout.entryLit(c2f({width-1, 0}, width));
+        const auto lit2 = layout.exitLit(c2f({width-1, 0}, width));
+        if (lit1 != Minisat::lit_Undef) s.addClause(~litw1, ~litw2, ~lit1);
+        if (lit2 != Minisat::lit_Undef) s.addClause(~litw1, ~litw2, ~lit2);
     }
     // bottom left corner
     {
-        const Wall w1({0, height-1}, Orientation::V);
-        const Wall w2({0, height}, Orientation::H);
-        const auto litw1 = w2lit[w1];
-        const auto litw2 = w2lit[w2];
-        const auto lit1 = fp2lit[{c2f({0, height-1}, width), 0}];
-        const auto lit2 = fp2lit[{c2f({0, height-1}, width), pathLength-1}];
-        s.addClause(~litw1, ~litw2, ~lit1);
-        s.addClause(~litw1, ~litw2, ~lit2);
+        const auto litw1 = layout.wall(Wall({0, height-1}, Orientation::V));
+        const auto litw2 = layout.wall(Wall({0, height}, Orientation::H));
+        const auto lit1 = layout.entryLit(c2f({0, height-1}, width));
+        const auto lit2 = layout.exitLit(c2f({0, height-1}, width));
+        if (lit1 != Minisat::lit_Undef) s.addClause(~litw1, ~litw2, ~lit1);
+        if (lit2 != Minisat::lit_Undef) s.addClause(~litw1, ~litw2, ~lit2);
     }
     // bottom right corner
     {
-        const Wall w1({width, height-1}, Orientation::V);
-        const Wall w2({width-1, height}, Orientation::H);
-        const auto litw1 = w2lit[w1];
-        const auto litw2 = w2lit[w2];
-        const auto lit1 = fp2lit[{c2f({width-1, height-1}, width), 0}];
-        const auto lit2 = fp2lit[{c2f({width-1, height-1}, width), pathLength-1}];
-        s.addClause(~litw1, ~litw2, ~lit1);
-        s.addClause(~litw1, ~litw2, ~lit2);
+        const auto litw1 = layout.wall(Wall({width, height-1}, Orientation::V));
+        const auto litw2 = layout.wall(Wall({width-1, height}, Orientation::H));
+        const auto lit1 = layout.entryLit(c2f({width-1, height-1}, width));
+        const auto lit2 = layout.exitLit(c2f({width-1, height-1}, width));
+        if (lit1 != Minisat::lit_Undef) s.addClause(~litw1, ~litw2, ~lit1);
+        if (lit2 != Minisat::lit_Undef) s.addClause(~litw1, ~litw2, ~lit2);
+    }
+}
+
+
+// border wall positions of a field; returns their number
+int borderWalls(const Coordinates& c, int width, int height, int* walls)
+{
+    int count = 0;
+    if (c.y() == 0)          walls[count++] = Wall(c, Orientation::H).id(width, height);
+    if (c.y() + 1 == height) walls[count++] = Wall(c.offset(0, 1), Orientation::H).id(width, height);
+    if (c.x() == 0)          walls[count++] = Wall(c, Orientation::V).id(width, height);
+    if (c.x() + 1 == width)  walls[count++] = Wall(c.offset(1, 0), Orientation::V).id(width, height);
+    return count;
+}
+
+
+void addEdgeEncoding(int width, int height, ClauseSink& s, FormulaLayout& layout)
+{
+    // The cell constraints above already force every field to have exactly two crossed wall
+    // positions; a path entry/exit is a crossed position on the board's border.
+    std::vector<Minisat::Lit> borderCrossings;
+    Clause clause;
+    int walls[4];
+    for (auto field: getEdgeFields(width, height))
+    {
+        const Minisat::Lit end = Minisat::mkLit(s.newVar());
+        layout.end(field) = end;
+
+        // end <=> one of the field's border wall positions is crossed
+        clause.clear();
+        clause.push(~end);
+        const int count = borderWalls(f2c(field, width), width, height, walls);
+        for (int i = 0; i < count; ++i)
+        {
+            const auto crossing = ~layout.edge(walls[i]);
+            s.addClause(~crossing, end);
+            clause.push(crossing);
+            borderCrossings.push_back(crossing);
+        }
+        s.addClause(clause);
+    }
+
+    // at least one and at most two border crossings (as the field degrees are even, this means exactly two)
+    clause.clear();
+    for (auto lit: borderCrossings)
+    {
+        clause.push(lit);
+    }
+    s.addClause(clause);
+    addAtMostK(s, borderCrossings, 2);
+
+    // connectivity (no disconnected cycles besides the path) is added lazily by solvePath
+}
+
+
+// The path leaves the board only at its ends: an entry/exit field crosses one of its border wall positions,
+// no other field does, and at most two border wall positions are crossed overall.
+void addEdgeEscape(int width, int height, ClauseSink& s, const FormulaLayout& layout)
+{
+    std::vector<Minisat::Lit> borderCrossings;
+    Clause clause;
+    int walls[4];
+    for (auto field: getEdgeFields(width, height))
+    {
+        const Minisat::Lit ends[2] = {layout.entryLit(field), layout.exitLit(field)};
+        const int count = borderWalls(f2c(field, width), width, height, walls);
+
+        // end -> one of the border wall positions is crossed
+        for (auto end: ends)
+        {
+            if (end == Minisat::lit_Undef) continue;
+            clause.clear();
+            clause.push(~end);
+            for (int i = 0; i < count; ++i) clause.push(~layout.edge(walls[i]));
+            s.addClause(clause);
+        }
+
+        // border wall position is crossed -> entry v exit
+        for (int i = 0; i < count; ++i)
+        {
+            clause.clear();
+            clause.push(layout.edge(walls[i]));
+            for (auto end: ends)
+            {
+                if (end != Minisat::lit_Undef) clause.push(end);
+            }
+            s.addClause(clause);
+            borderCrossings.push_back(~layout.edge(walls[i]));
+        }
+    }
+    addAtMostK(s, borderCrossings, 2);
+}
+
+
+// Every straight cut between two rows (columns) splits the board into two rectangles. As each field has exactly
+// two crossed wall positions, the crossings of a rectangle's boundary (the cut plus its part of the border) are even.
+void addBoundaryParity(int width, int height, ClauseSink& s, const FormulaLayout& layout)
+{
+    std::vector<Minisat::Lit> crossings;
+
+    // rows 0..y-1
+    for (int y = 1; y < height; ++y)
+    {
+        crossings.clear();
+        for (int x = 0; x < width; ++x)
+        {
+            crossings.push_back(~layout.edge(Wall({x, y}, Orientation::H)));
+            crossings.push_back(~layout.edge(Wall({x, 0}, Orientation::H)));
+        }
+        for (int row = 0; row < y; ++row)
+        {
+            crossings.push_back(~layout.edge(Wall({0, row}, Orientation::V)));
+            crossings.push_back(~layout.edge(Wall({width, row}, Orientation::V)));
+        }
+        addParity(s, crossings, false);
+    }
+
+    // columns 0..x-1
+    for (int x = 1; x < width; ++x)
+    {
+        crossings.clear();
+        for (int y = 0; y < height; ++y)
+        {
+            crossings.push_back(~layout.edge(Wall({x, y}, Orientation::V)));
+            crossings.push_back(~layout.edge(Wall({0, y}, Orientation::V)));
+        }
+        for (int column = 0; column < x; ++column)
+        {
+            crossings.push_back(~layout.edge(Wall({column, 0}, Orientation::H)));
+            crossings.push_back(~layout.edge(Wall({column, height}, Orientation::H)));
+        }
+        addParity(s, crossings, false);
+    }
+}
+
+
+void addBinaryEncoding(int width, int height, const FormulaOptions& options, ClauseSink& s, FormulaLayout& layout)
+{
+    const int pathLength = width * height;
+    int bits = 1;
+    while ((1 << bits) < pathLength)
+    {
+        ++bits;
+    }
+    layout.setBits(bits);
+
+    // position bits, and their increment (pos+1) via a ripple carry chain:
+    // inc_0 = ~b_0, carry_1 = b_0, inc_i = b_i ^ carry_i, carry_i+1 = b_i & carry_i
+    std::vector<Minisat::Lit> inc(pathLength * bits);
+    Clause clause;
+    Clause clause2;
+    for (int field = 0; field < pathLength; ++field)
+    {
+        for (int i = 0; i < bits; ++i)
+        {
+            layout.bit(field, i) = Minisat::mkLit(s.newVar());
+        }
+        const auto b = [&](int i) { return layout.bit(field, i); };
+
+        inc[field * bits] = ~b(0);
+        Minisat::Lit carry = b(0);
+        for (int i = 1; i < bits; ++i)
+        {
+            const Minisat::Lit sum = Minisat::mkLit(s.newVar());
+            s.addClause(~sum, b(i), carry);
+            s.addClause(~sum, ~b(i), ~carry);
+            s.addClause(sum, ~b(i), carry);
+            s.addClause(sum, b(i), ~carry);
+            inc[field * bits + i] = sum;
+
+            if (i + 1 < bits)
+            {
+                const Minisat::Lit nextCarry = Minisat::mkLit(s.newVar());
+                s.addClause(~nextCarry, b(i));
+                s.addClause(~nextCarry, carry);
+                s.addClause(nextCarry, ~b(i), ~carry);
+                carry = nextCarry;
+            }
+        }
+
+        // entry <=> pos = 0, exit <=> pos = P-1
+        const Minisat::Lit entry = Minisat::mkLit(s.newVar());
+        const Minisat::Lit exit = Minisat::mkLit(s.newVar());
+        layout.first(field) = entry;
+        layout.last(field) = exit;
+        clause.clear();
+        clause2.clear();
+        clause.push(entry);
+        clause2.push(exit);
+        for (int i = 0; i < bits; ++i)
+        {
+            s.addClause(~entry, ~b(i));
+            clause.push(b(i));
+
+            const Minisat::Lit last = (((pathLength - 1) >> i) & 1) ? b(i) : ~b(i);
+            s.addClause(~exit, last);
+            clause2.push(~last);
+        }
+        s.addClause(clause);
+        s.addClause(clause2);
+    }
+
+    // exactly one field is the entry
+    std::vector<Minisat::Lit> entries(pathLength);
+    for (int field = 0; field < pathLength; ++field)
+    {
+        entries[field] = layout.first(field);
+    }
+    addExactlyOne(s, entries, options.positionAmo);
+
+    // successor relation between neighbours
+    Neighbour neighbours[4];
+    for (int field = 0; field < pathLength; ++field)
+    {
+        const int count = getNeighbours(field, width, height, neighbours);
+        for (int n = 0; n < count; ++n)
+        {
+            const int next = neighbours[n].field;
+            const Minisat::Lit succ = Minisat::mkLit(s.newVar());
+            layout.succ(field, next) = succ;
+
+            // no successor through a wall
+            s.addClause(~succ, ~layout.wall(neighbours[n].wall));
+
+            // succ(f, g) -> pos(g) = pos(f) + 1
+            for (int i = 0; i < bits; ++i)
+            {
+                s.addClause(~succ, ~inc[field * bits + i], layout.bit(next, i));
+                s.addClause(~succ, inc[field * bits + i], ~layout.bit(next, i));
+            }
+
+            // the entry has no predecessor (this also rules out an overflow of pos(f) + 1), the exit has no successor
+            s.addClause(~succ, ~layout.first(next));
+            s.addClause(~succ, ~layout.last(field));
+        }
+    }
+
+    // every field but the entry has exactly one predecessor, every field but the exit has exactly one successor;
+    // since positions increase along the successor relation, it forms a single path
+    std::vector<Minisat::Lit> predecessors;
+    std::vector<Minisat::Lit> successors;
+    for (int field = 0; field < pathLength; ++field)
+    {
+        predecessors.clear();
+        successors.clear();
+        const int count = getNeighbours(field, width, height, neighbours);
+        for (int n = 0; n < count; ++n)
+        {
+            predecessors.push_back(layout.succ(neighbours[n].field, field));
+            successors.push_back(layout.succ(field, neighbours[n].field));
+        }
+
+        clause.clear();
+        clause.push(layout.first(field));
+        for (auto lit: predecessors) clause.push(lit);
+        s.addClause(clause);
+        addAtMostOne(s, predecessors, AmoEncoding::Pairwise);
+
+        clause.clear();
+        clause.push(layout.last(field));
+        for (auto lit: successors) clause.push(lit);
+        s.addClause(clause);
+        addAtMostOne(s, successors, AmoEncoding::Pairwise);
+    }
+
+    addEntryExit(width, height, s, layout);
+}
+
+
+bool isTrue(const SatSolver& s, Minisat::Lit lit)
+{
+    return Minisat::toInt(s.modelValue(lit)) == 0 /* = Minisat::l_True */;
+}
+
+
+// connected components of the fields w.r.t. the crossed (internal) wall positions of the current model
+std::vector<int> getComponents(const SatSolver& s, const FormulaLayout& layout, int& count)
+{
+    const int width = layout.width();
+    const int height = layout.height();
+    std::vector<int> component(layout.fields(), -1);
+    std::vector<int> stack;
+    Neighbour neighbours[4];
+    count = 0;
+
+    for (int start = 0; start < layout.fields(); ++start)
+    {
+        if (component[start] >= 0) continue;
+
+        stack.push_back(start);
+        component[start] = count;
+        while (!stack.empty())
+        {
+            const int field = stack.back();
+            stack.pop_back();
+
+            const int n = getNeighbours(field, width, height, neighbours);
+            for (int i = 0; i < n; ++i)
+            {
+                const int nf = neighbours[i].field;
+                if (component[nf] >= 0 || isTrue(s, layout.edge(neighbours[i].wall))) continue;
+                component[nf] = count;
+                stack.push_back(nf);
+            }
+        }
+        ++count;
+    }
+
+    return component;
+}
+
+
+bool preprocessFormula(SatSolver& s, const FormulaLayout& layout)
+{
+    std::vector<Minisat::Lit> lits;
+    layout.save(lits);
+    std::vector<Minisat::Var> frozen;
+    for (auto lit: lits)
+    {
+        // the presolve leaves pruned position variables undefined
+        if (lit != Minisat::lit_Undef)
+        {
+            frozen.push_back(Minisat::var(lit));
+        }
+    }
+    return s.preprocess(frozen);
+}
+
+
+Minisat::lbool solvePath(SatSolver& s, const FormulaLayout& layout, const Minisat::vec<Minisat::Lit>& assumptions)
+{
+    Minisat::lbool result;
+    while ((result = s.solveLimited(assumptions)) == l_True)
+    {
+        if (layout.encoding() != PathEncoding::Edge)
+        {
+            return l_True;
+        }
+
+        int count = 0;
+        const std::vector<int> component = getComponents(s, layout, count);
+        if (count == 1)
+        {
+            return l_True;
+        }
+
+        // every component without path end is a cycle: the path has to cross one of its boundary wall positions
+        std::vector<bool> hasEnd(count, false);
+        for (auto field: getEdgeFields(layout.width(), layout.height()))
+        {
+            if (isTrue(s, layout.end(field))) hasEnd[component[field]] = true;
+        }
+
+        std::vector<Clause> cuts(count);
+        for (int id = 0; id < layout.walls(); ++id)
+        {
+            const Wall wall = Wall::fromId(id, layout.width(), layout.height());
+            const Coordinates c1 = wall.m_coordinates;
+            const Coordinates c2 = (wall.m_orientation == Orientation::H) ? c1.offset(0, -1) : c1.offset(-1, 0);
+            const bool inside1 = c1.x() < layout.width() && c1.y() < layout.height();
+            const bool inside2 = c2.x() >= 0 && c2.y() >= 0;
+            const int comp1 = inside1 ? component[layout.c2f(c1)] : -1;
+            const int comp2 = inside2 ? component[layout.c2f(c2)] : -1;
+            if (comp1 == comp2) continue;
+
+            if (comp1 >= 0) cuts[comp1].push(~layout.edge(id));
+            if (comp2 >= 0) cuts[comp2].push(~layout.edge(id));
+        }
+        for (int i = 0; i < count; ++i)
+        {
+            if (!hasEnd[i])
+            {
+                s.addClause(cuts[i]);
+            }
+        }
+    }
+    return result;
+}
+
+
+bool isPath(const SatSolver& s, const FormulaLayout& layout)
+{
+    if (layout.encoding() != PathEncoding::Edge)
+    {
+        return true;
+    }
+
+    int count = 0;
+    getComponents(s, layout, count);
+    return count == 1;
+}
+
+
+Path extractPath(const SatSolver& s, const FormulaLayout& layout)
+{
+    const int pathLength = layout.fields();
+    Path path(pathLength);
+
+    if (layout.encoding() == PathEncoding::Position)
+    {
+        for (int field = 0; field < pathLength; ++field)
+        {
+            for (int pos = 0; pos < pathLength; ++pos)
+            {
+                if (layout.fp(field, pos) != Minisat::lit_Undef && isTrue(s, layout.fp(field, pos)))
+                {
+                    path.set(pos, layout.f2c(field));
+                }
+            }
+        }
+        return path;
+    }
+
+    if (layout.encoding() == PathEncoding::Binary)
+    {
+        for (int field = 0; field < pathLength; ++field)
+        {
+            int pos = 0;
+            for (int i = 0; i < layout.bits(); ++i)
+            {
+                if (isTrue(s, layout.bit(field, i))) pos |= (1 << i);
+            }
+            path.set(pos, layout.f2c(field));
+        }
+        return path;
+    }
+
+    // edge encoding: walk from the lower numbered end along the crossed wall positions
+    int field = -1;
+    for (int f = 0; f < pathLength && field < 0; ++f)
+    {
+        if (layout.end(f) != Minisat::lit_Undef && isTrue(s, layout.end(f)))
+        {
+            field = f;
+        }
+    }
+
+    Neighbour neighbours[4];
+    int previous = -1;
+    for (int pos = 0; pos < pathLength; ++pos)
+    {
+        path.set(pos, layout.f2c(field));
+
+        const int count = getNeighbours(field, layout.width(), layout.height(), neighbours);
+        int next = -1;
+        for (int i = 0; i < count; ++i)
+        {
+            const int nf = neighbours[i].field;
+            if (nf != previous && !isTrue(s, layout.edge(neighbours[i].wall)))
+            {
+                next = nf;
+                break;
+            }
+        }
+        previous = field;
+        field = next;
+    }
+
+    return path;
+}
+
+
+void pathClause(const FormulaLayout& layout, const Path& path, Clause& clause)
+{
+    clause.clear();
+    if (layout.encoding() == PathEncoding::Position)
+    {
+        for (unsigned int pos = 0; pos < path.size(); ++pos)
+        {
+            clause.push(~layout.fp(layout.c2f(path.at(pos)), static_cast<int>(pos)));
+        }
+        return;
+    }
+
+    if (layout.encoding() == PathEncoding::Binary)
+    {
+        for (unsigned int pos = 0; pos + 1 < path.size(); ++pos)
+        {
+            clause.push(~layout.succ(layout.c2f(path.at(pos)), layout.c2f(path.at(pos + 1))));
+        }
+        return;
+    }
+
+    // the crossed wall positions between consecutive fields identify the path
+    for (unsigned int pos = 0; pos + 1 < path.size(); ++pos)
+    {
+        const Coordinates& c1 = path.at(pos);
+        const Coordinates& c2 = path.at(pos + 1);
+        const Coordinates c = (c1 < c2) ? c2 : c1;
+        const Wall wall(c, (c1.x() == c2.x()) ? Orientation::H : Orientation::V);
+        clause.push(layout.edge(wall));
     }
 }
@@ -24,12 +24,169 @@
 
 #pragma once
 
-#include <map>
+#include <string>
 #include <utility>
-class Wall;
-namespace Minisat { class SimpSolver; }
-namespace Minisat { class Solver; }
-namespace Minisat { class Lit; }
-typedef Minisat::SimpSolver SatSolver;
+#include <vector>
 
-void buildFormula(int width, int height, SatSolver& s, std::map<std::pair<int, int>, Minisat::Lit>& field_pathpos2lit, std::map<Wall, Minisat::Lit>& wall2lit);
+#include <core/SolverTypes.h>
+
+#include "coordinates.h"
+#include "path.h"
+#include "wall.h"
+
+class ClauseSink;
+class SatSolver;
+class TemplateBoard;
+
+enum class PathEncoding
+{
+    // one variable per (field, path position)
+    Position,
+    // one variable per crossed wall, connectivity is enforced lazily
+    Edge,
+    // path position of each field as binary number
+    Binary
+};
+
+enum class AmoEncoding
+{
+    Pairwise,
+    Sequential,
+    Commander,
+    Product
+};
+
+struct FormulaOptions
+{
+    PathEncoding pathEncoding = PathEncoding::Position;
+    // encoding of "each field appears exactly once on the path"
+    AmoEncoding fieldAmo = AmoEncoding::Pairwise;
+    // encoding of "each path position holds exactly one field"
+    AmoEncoding positionAmo = AmoEncoding::Pairwise;
+    // redundant: orientation of the nodes between the fields along the crossed wall positions
+    bool nodeStructure = true;
+    // redundant (position encoding): f@p -> ~g@p+1 for all non-neighbours g of f
+    bool nonNeighbours = true;
+    // redundant: only the path's ends cross the board's border
+    bool edgeEscape = false;
+    // redundant: crossings of every straight cut have the parity of the border crossings on either side (edge encoding
+    // only: the other encodings do not tie the crossed wall positions to the path)
+    bool boundaryParity = false;
+};
+
+struct FormulaStats
+{
+    // variables/clauses spent on the exactly-one constraints of fields and positions
+    int cardinalityVariables = 0;
+    int cardinalityClauses = 0;
+    // (field, position) variables removed by the parity/reachability presolve
+    int prunedVariables = 0;
+    // clauses satisfied by the template's fixed walls, which are not emitted
+    int foldedClauses = 0;
+};
+
+// Variables of the formula; all lookups are plain index arithmetic on contiguous arrays.
+class FormulaLayout
+{
+    public:
+        FormulaLayout() = default;
+        FormulaLayout(int width, int height, PathEncoding encoding);
+
+        PathEncoding encoding() const { return m_encoding; }
+        int width() const { return m_width; }
+        int height() const { return m_height; }
+        int fields() const { return m_width * m_height; }
+        int walls() const { return Wall::count(m_width, m_height); }
+        int bits() const { return m_bits; }
+
+        int c2f(const Coordinates& c) const { return c.x() + m_width * c.y(); }
+        Coordinates f2c(int f) const { return {f % m_width, f / m_width}; }
+
+        // field f is the path's pth step (position encoding only; lit_Undef if pruned by the presolve)
+        const Minisat::Lit& fp(int field, int pos) const { return m_fp[field * fields() + pos]; }
+        Minisat::Lit& fp(int field, int pos) { return m_fp[field * fields() + pos]; }
+
+        // wall is closed
+        const Minisat::Lit& wall(int id) const { return m_wall[id]; }
+        Minisat::Lit& wall(int id) { return m_wall[id]; }
+        const Minisat::Lit& wall(const Wall& w) const { return m_wall[w.id(m_width, m_height)]; }
+
+        // path does not cross the wall position
+        const Minisat::Lit& edge(int id) const { return m_edge[id]; }
+        Minisat::Lit& edge(int id) { return m_edge[id]; }
+        const Minisat::Lit& edge(const Wall& w) const { return m_edge[w.id(m_width, m_height)]; }
+
+        // edge field is the entry or exit of the path (edge encoding only)
+        const Minisat::Lit& end(int field) const { return m_end[field]; }
+        Minisat::Lit& end(int field) { return m_end[field]; }
+
+        // bit i of the field's path position, least significant first (binary encoding only)
+        void setBits(int bits) { m_bits = bits; m_bit.assign(fields() * bits, Minisat::lit_Undef); }
+        const Minisat::Lit& bit(int field, int i) const { return m_bit[field * m_bits + i]; }
+        Minisat::Lit& bit(int field, int i) { return m_bit[field * m_bits + i]; }
+
+        // field next is the successor of the neighbouring field (binary encoding only)
+        const Minisat::Lit& succ(int field, int next) const { return m_succ[4 * field + direction(field, next)]; }
+        Minisat::Lit& succ(int field, int next) { return m_succ[4 * field + direction(field, next)]; }
+
+        // field is at the first/last path position (binary encoding only)
+        const Minisat::Lit& first(int field) const { return m_first[field]; }
+        Minisat::Lit& first(int field) { return m_first[field]; }
+        const Minisat::Lit& last(int field) const { return m_last[field]; }
+        Minisat::Lit& last(int field) { return m_last[field]; }
+
+        // literals fixing the path's entry/exit field
+        Minisat::Lit entryLit(int field) const;
+        Minisat::Lit exitLit(int field) const;
+
+        // all literals in a fixed order (formula cache); load expects a layout constructed with the same size, encoding and bits
+        void save(std::vector<Minisat::Lit>& lits) const;
+        bool load(const Minisat::Lit* lits, int size);
+
+    private:
+        int direction(int field, int next) const { return (next == field - 1) ? 0 : (next == field + 1) ? 1 : (next < field) ? 2 : 3; }
+
+        PathEncoding m_encoding = PathEncoding::Position;
+        int m_width = 0;
+        int m_height = 0;
+        int m_bits = 0;
+
+        std::vector<Minisat::Lit> m_fp;
+        std::vector<Minisat::Lit> m_wall;
+        std::vector<Minisat::Lit> m_edge;
+        std::vector<Minisat::Lit> m_end;
+        std::vector<Minisat::Lit> m_bit;
+        std::vector<Minisat::Lit> m_succ;
+        std::vector<Minisat::Lit> m_first;
+        std::vector<Minisat::Lit> m_last;
+};
+
+bool parsePathEncoding(const std::string& name, PathEncoding& encoding);
+std::string toString(PathEncoding encoding);
+
+// the template's fixed closed walls and open edge fields restrict the (field, position) variables that are created;
+// the fixed walls (and the wall positions fixed closed walls keep the path from crossing) are constant-folded: they share
+// one literal that is true, so the layout's literals of all fixed walls are that literal or its negation
+FormulaStats buildFormula(const TemplateBoard& templateBoard, const FormulaOptions& options, ClauseSink& s, FormulaLayout& layout);
+
+// the fields along the board's border, the only possible entry and exit fields of the path
+std::vector<int> getEdgeFields(int width, int height);
+
+// order two end fields of a path as (entry, exit) the way the formula breaks the direction symmetry
+void orderEnds(const FormulaLayout& layout, int& entry, int& exit);
+
+// preprocess the formula (SatSolver::preprocess) keeping all variables of the layout, which queries assume, extract or block
+bool preprocessFormula(SatSolver& s, const FormulaLayout& layout);
+
+// solve under assumptions; in the edge encoding, disconnected cycles of the model are cut off and the formula is re-solved;
+// l_Undef if the solver was interrupted
+Minisat::lbool solvePath(SatSolver& s, const FormulaLayout& layout, const Minisat::vec<Minisat::Lit>& assumptions);
+
+// the solver's current model is a single path (models of the edge encoding may contain disconnected cycles)
+bool isPath(const SatSolver& s, const FormulaLayout& layout);
+
+// path of the solver's current model
+Path extractPath(const SatSolver& s, const FormulaLayout& layout);
+
+// clause forbidding the given path
+void pathClause(const FormulaLayout& layout, const Path& path, Minisat::vec<Minisat::Lit>& clause);
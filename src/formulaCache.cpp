@@ -0,0 +1,320 @@
+/*******************************************************************************
+* alcazar-gen
+*
+* Copyright (c) 2015 Florian Pigorsch
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "clauseSink.h"
+#include "formulaCache.h"
+#include "templateBoard.h"
+#include "wall.h"
+
+static_assert(sizeof(Minisat::Lit) == sizeof(std::int32_t), "literals are mapped as 32 bit integers");
+
+namespace
+{
+    // the file is a sequence of 32 bit integers: header, clause offsets, clause literals, layout literals
+    enum HeaderField
+    {
+        Magic,
+        Version,
+        KeyLow,
+        KeyHigh,
+        Width,
+        Height,
+        Encoding,
+        Bits,
+        Vars,
+        Clauses,
+        Literals,
+        LayoutLiterals,
+        CardinalityVariables,
+        CardinalityClauses,
+        PrunedVariables,
+        FoldedClauses,
+        HeaderSize
+    };
+
+    const std::int32_t magic = 0x7a636c61; // "alcz"
+    // bump whenever buildFormula or the file format changes, so stale cache files are no longer found
+    const std::int32_t version = 2;
+}
+
+
+MappedFormula::~MappedFormula()
+{
+    close();
+}
+
+
+void MappedFormula::close()
+{
+    if (m_data != nullptr)
+    {
+        munmap(m_data, m_size);
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_header = nullptr;
+    m_offsets = nullptr;
+    m_lits = nullptr;
+    m_layout = nullptr;
+    m_literals = 0;
+}
+
+
+bool MappedFormula::open(const std::string& fileName, std::uint64_t key)
+{
+    close();
+
+    const int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < HeaderSize * sizeof(std::int32_t))
+    {
+        ::close(fd);
+        return false;
+    }
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED)
+    {
+        return false;
+    }
+    m_data = data;
+    m_size = st.st_size;
+
+    const std::int32_t* header = static_cast<const std::int32_t*>(m_data);
+    const std::uint64_t storedKey = static_cast<std::uint32_t>(header[KeyLow]) | (static_cast<std::uint64_t>(static_cast<std::uint32_t>(header[KeyHigh])) << 32);
+    const std::size_t ints = std::size_t(HeaderSize) + header[Clauses] + header[Literals] + header[LayoutLiterals];
+    if (header[Magic] != magic || header[Version] != version || storedKey != key
+        || header[Clauses] < 0 || header[Literals] < 0 || header[LayoutLiterals] < 0 || m_size != ints * sizeof(std::int32_t))
+    {
+        close();
+        return false;
+    }
+
+    m_header = header;
+    m_offsets = header + HeaderSize;
+    m_lits = reinterpret_cast<const Minisat::Lit*>(m_offsets + header[Clauses]);
+    m_layout = m_lits + header[Literals];
+    m_literals = header[Literals];
+    return true;
+}
+
+
+int MappedFormula::nVars() const
+{
+    return m_header[Vars];
+}
+
+
+int MappedFormula::size() const
+{
+    return m_header[Clauses];
+}
+
+
+void MappedFormula::replay(ClauseSink& sink) const
+{
+    while (sink.nVars() < nVars())
+    {
+        sink.newVar();
+    }
+    for (int i = 0; i < size(); ++i)
+    {
+        sink.addClause(clause(i), clauseSize(i));
+    }
+}
+
+
+bool MappedFormula::layout(FormulaLayout& layout) const
+{
+    layout = FormulaLayout(m_header[Width], m_header[Height], static_cast<PathEncoding>(m_header[Encoding]));
+    if (m_header[Bits] > 0)
+    {
+        layout.setBits(m_header[Bits]);
+    }
+    return layout.load(m_layout, m_header[LayoutLiterals]);
+}
+
+
+FormulaStats MappedFormula::stats() const
+{
+    FormulaStats stats;
+    stats.cardinalityVariables = m_header[CardinalityVariables];
+    stats.cardinalityClauses = m_header[CardinalityClauses];
+    stats.prunedVariables = m_header[PrunedVariables];
+    stats.foldedClauses = m_header[FoldedClauses];
+    return stats;
+}
+
+
+std::uint64_t formulaKey(const TemplateBoard& templateBoard, const FormulaOptions& options)
+{
+    // FNV-1a
+    std::uint64_t hash = 14695981039346656037ull;
+    const auto add = [&hash](int value)
+    {
+        hash ^= static_cast<std::uint32_t>(value);
+        hash *= 1099511628211ull;
+    };
+
+    add(version);
+    add(templateBoard.width());
+    add(templateBoard.height());
+    add(static_cast<int>(options.pathEncoding));
+    add(static_cast<int>(options.fieldAmo));
+    add(static_cast<int>(options.positionAmo));
+    add(options.nodeStructure);
+    add(options.nonNeighbours);
+    add(options.edgeEscape);
+    add(options.boundaryParity);
+
+    for (int id = 0; id < Wall::count(templateBoard.width(), templateBoard.height()); ++id)
+    {
+        const Wall wall = Wall::fromId(id, templateBoard.width(), templateBoard.height());
+        add(templateBoard.getFixedClosedWalls().count(wall) ? 1 : templateBoard.getFixedOpenWalls().count(wall) ? 2 : 0);
+    }
+    return hash;
+}
+
+
+bool storeFormula(const std::string& fileName, std::uint64_t key, const ClauseBuffer& formula, const FormulaLayout& layout, const FormulaStats& stats,
+                  std::ostream& log)
+{
+    std::vector<Minisat::Lit> layoutLits;
+    layout.save(layoutLits);
+
+    std::vector<std::int32_t> header(HeaderSize, 0);
+    header[Magic] = magic;
+    header[Version] = version;
+    header[KeyLow] = static_cast<std::int32_t>(key & 0xffffffffu);
+    header[KeyHigh] = static_cast<std::int32_t>(key >> 32);
+    header[Width] = layout.width();
+    header[Height] = layout.height();
+    header[Encoding] = static_cast<std::int32_t>(layout.encoding());
+    header[Bits] = layout.bits();
+    header[Vars] = formula.nVars();
+    header[Clauses] = formula.size();
+    header[Literals] = 0;
+    header[LayoutLiterals] = static_cast<std::int32_t>(layoutLits.size());
+    header[CardinalityVariables] = stats.cardinalityVariables;
+    header[CardinalityClauses] = stats.cardinalityClauses;
+    header[PrunedVariables] = stats.prunedVariables;
+    header[FoldedClauses] = stats.foldedClauses;
+
+    std::vector<std::int32_t> offsets(formula.size());
+    for (int i = 0; i < formula.size(); ++i)
+    {
+        offsets[i] = header[Literals];
+        header[Literals] += formula.clauseSize(i);
+    }
+
+    // unique per writer: threads of one process (batch workers) may store the same formula at the same time
+    const std::string pattern = fileName + ".tmpXXXXXX";
+    std::vector<char> temporaryName(pattern.c_str(), pattern.c_str() + pattern.size() + 1);
+    const int fd = mkstemp(temporaryName.data());
+    if (fd < 0)
+    {
+        log << "Error: cannot create a temporary formula cache file next to '" << fileName << "'" << std::endl;
+        return false;
+    }
+    fchmod(fd, 0644);
+    ::close(fd);
+    const std::string temporary(temporaryName.data());
+    {
+        std::ofstream file(temporary, std::ios::binary);
+        if (!file)
+        {
+            log << "Error: cannot open formula cache file '" << temporary << "' for writing" << std::endl;
+            std::remove(temporary.c_str());
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(header.data()), header.size() * sizeof(std::int32_t));
+        file.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(std::int32_t));
+        for (int i = 0; i < formula.size(); ++i)
+        {
+            file.write(reinterpret_cast<const char*>(formula.clause(i)), formula.clauseSize(i) * sizeof(Minisat::Lit));
+        }
+        file.write(reinterpret_cast<const char*>(layoutLits.data()), layoutLits.size() * sizeof(Minisat::Lit));
+        if (!file)
+        {
+            log << "Error: cannot write formula cache file '" << temporary << "'" << std::endl;
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temporary.c_str(), fileName.c_str()) != 0)
+    {
+        log << "Error: cannot rename '" << temporary << "' to '" << fileName << "'" << std::endl;
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+
+FormulaStats loadFormula(const std::string& cacheDirectory, const TemplateBoard& templateBoard, const FormulaOptions& options, ClauseSink& s, FormulaLayout& layout,
+                         std::ostream& log)
+{
+    if (cacheDirectory.empty())
+    {
+        return buildFormula(templateBoard, options, s, layout);
+    }
+
+    const std::uint64_t key = formulaKey(templateBoard, options);
+    std::ostringstream name;
+    name << cacheDirectory << "/formula-" << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+    const std::string fileName = name.str();
+
+    MappedFormula mapped;
+    if (mapped.open(fileName, key) && mapped.layout(layout))
+    {
+        mapped.replay(s);
+        log << "Info: loaded formula from cache file '" << fileName << "'" << std::endl;
+        return mapped.stats();
+    }
+
+    ClauseBuffer formula;
+    const FormulaStats stats = buildFormula(templateBoard, options, formula, layout);
+    if (storeFormula(fileName, key, formula, layout, stats, log))
+    {
+        log << "Info: stored formula in cache file '" << fileName << "'" << std::endl;
+    }
+    formula.replay(s);
+    return stats;
+}
@@ -0,0 +1,87 @@
+/*******************************************************************************
+* alcazar-gen
+*
+* Copyright (c) 2015 Florian Pigorsch
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include <core/SolverTypes.h>
+
+#include "formula.h"
+
+class ClauseBuffer;
+class ClauseSink;
+class TemplateBoard;
+
+// Read-only memory mapping of a cached formula file: the clause arena, the variable layout and the formula's stats.
+// The clauses are replayed straight from the mapping, nothing is parsed or copied on load.
+class MappedFormula
+{
+    public:
+        MappedFormula() = default;
+        ~MappedFormula();
+        MappedFormula(const MappedFormula&) = delete;
+        MappedFormula& operator=(const MappedFormula&) = delete;
+
+        // map the file; fails if it is missing, truncated or was stored under a different key
+        bool open(const std::string& fileName, std::uint64_t key);
+
+        int nVars() const;
+        int size() const;
+        const Minisat::Lit* clause(int i) const { return m_lits + m_offsets[i]; }
+        int clauseSize(int i) const { return ((i + 1 < size()) ? m_offsets[i + 1] : m_literals) - m_offsets[i]; }
+
+        // add the variables (if the sink has fewer) and all clauses to the sink
+        void replay(ClauseSink& sink) const;
+
+        bool layout(FormulaLayout& layout) const;
+        FormulaStats stats() const;
+
+    private:
+        void close();
+
+        void* m_data = nullptr;
+        std::size_t m_size = 0;
+        const std::int32_t* m_header = nullptr;
+        const std::int32_t* m_offsets = nullptr;
+        const Minisat::Lit* m_lits = nullptr;
+        const Minisat::Lit* m_layout = nullptr;
+        int m_literals = 0;
+};
+
+// identifies the formula of a template and options (board size, fixed walls, encoding options, file format)
+std::uint64_t formulaKey(const TemplateBoard& templateBoard, const FormulaOptions& options);
+
+// write the formula file (via a temporary file, so concurrent runs never map a partially written file)
+// (errors are written to the log)
+bool storeFormula(const std::string& fileName, std::uint64_t key, const ClauseBuffer& formula, const FormulaLayout& layout, const FormulaStats& stats,
+                  std::ostream& log);
+
+// Like buildFormula, but with a non-empty cache directory the formula is loaded from <directory>/formula-<key>.bin
+// if present, and built and stored there otherwise; both are reported to the log.
+FormulaStats loadFormula(const std::string& cacheDirectory, const TemplateBoard& templateBoard, const FormulaOptions& options, ClauseSink& s, FormulaLayout& layout,
+                         std::ostream& log);
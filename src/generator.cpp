@@ -22,62 +22,157 @@
 * SOFTWARE.
 *******************************************************************************/
 
-#include <unordered_set>
-
-#include <core/Solver.h>
-#include <simp/SimpSolver.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
 
+#include "cardinality.h"
+#include "clauseSink.h"
 #include "formula.h"
+#include "formulaCache.h"
 #include "generator.h"
+#include "satSolver.h"
+
+
+unsigned int deriveSeed(unsigned int master, unsigned int index)
+{
+    // splitmix64
+    std::uint64_t z = ((static_cast<std::uint64_t>(master) << 32) | index) + 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    z ^= z >> 31;
+
+    // seed 0 would make the generator pick a random seed
+    const unsigned int seed = static_cast<unsigned int>(z >> 32);
+    return (seed == 0) ? 1 : seed;
+}
 
 
-Generator::Generator(const TemplateBoard& templateBoard, unsigned int seed) :
-  m_template(templateBoard)
+void prepareFormula(const TemplateBoard& templateBoard, const FormulaOptions& options, const std::string& cacheDirectory, PreparedFormula& formula,
+                    std::ostream& log)
+{
+    formula.clauses = ClauseBuffer();
+    formula.stats = loadFormula(cacheDirectory, templateBoard, options, formula.clauses, formula.layout, log);
+}
+
+
+Generator::Generator(const TemplateBoard& templateBoard, const FormulaOptions& options, const DimacsOptions& dimacs, const SolverOptions& solver, const std::string& cacheDirectory, unsigned int seed,
+                     std::ostream& log) :
+  m_template(templateBoard),
+  m_options(options),
+  m_cacheDirectory(cacheDirectory),
+  m_speculate(solver.speculate),
+  m_blockAlternatives(solver.blockAlternatives),
+  m_quickXplain(solver.quickXplain),
+  m_backbone(solver.backbone),
+  m_reuse(solver.reuse),
+  m_preprocess(solver.preprocess),
+  m_log(log),
+  m_query(dimacs, solver, "gen", log),
+  m_cancelled(false)
+{
+    setSeed(seed);
+}
+
+
+void Generator::setSeed(unsigned int seed)
 {
     if (seed == 0)
     {
         seed = std::random_device()();
     }
-    std::cout << "Info: using seed " << seed << std::endl;
+    m_log << "Info: using seed " << seed << std::endl;
     m_rng.seed(seed);
 }
 
 
-Board Generator::get()
+GeneratorResult Generator::get()
 {
     if (w() < 2 || h() < 2)
     {
-        std::cout << "Error: the template board must be at least 2x2" << std::endl;
-        return Board();
+        m_log << "Error: the template board must be at least 2x2" << std::endl;
+        return GeneratorResult();
     }
 
     const std::vector<Coordinates> edgeFields = m_template.getNonBlockedEdgeFields();
     if (edgeFields.size() < 2)
     {
-        std::cout << "Error: the board template needs at least 2 open edge fields" << std::endl;
-        return Board();
+        m_log << "Error: the board template needs at least 2 open edge fields" << std::endl;
+        return GeneratorResult();
     }
     
-    const int pathLength = w() * h();
-    
-    SatSolver s;
-    std::unordered_set<int> conflict;
-    m_fp2lit.clear();
-    m_w2lit.clear();
-    buildFormula(w(), h(), s, m_fp2lit, m_w2lit);
-    
-    std::cout << "Info: SAT encoding has " << s.nVars() << " variables and " << s.nClauses() << " clauses" << std::endl;
+    const bool reused = m_reuse && m_solver;
+    if (!reused)
+    {
+        std::lock_guard<std::mutex> lock(m_solverMutex);
+        m_solver.reset(new SatSolver());
+        if (!m_preprocess) m_solver->disablePreprocessing();
+        if (m_cancelled) m_solver->interrupt();
+    }
+    SatSolver& s = *m_solver;
+    std::vector<bool> conflict;
+    if (!reused)
+    {
+        s.setRecording(m_query.needsRecording());
+        SolverSink sink(s);
+        const auto start = std::chrono::steady_clock::now();
+        if (m_formula != nullptr)
+        {
+            m_formula->clauses.replay(sink);
+            m_layout = m_formula->layout;
+            m_stats = m_formula->stats;
+            // the encoding as built, not what the solver keeps of it
+            m_formulaVars = m_formula->clauses.nVars();
+            m_formulaClauses = m_formula->clauses.size();
+        }
+        else
+        {
+            m_stats = loadFormula(m_cacheDirectory, m_template, m_options, sink, m_layout, m_log);
+            m_formulaVars = sink.nVars();
+            m_formulaClauses = sink.nClauses();
+        }
+        m_log << "Info: loaded the formula into the solver in " << std::fixed << std::setprecision(2)
+              << 1000 * std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << " ms"
+              << std::defaultfloat << std::setprecision(6) << std::endl;
 
-    std::cout << "Info: creating initial path" << std::flush;
-    for (auto wall: m_template.getFixedClosedWalls())
+        // either way, elimination is off from here on: the puzzle clauses and queries do without occurrence lists
+        if (m_preprocess)
+        {
+            const int clauses = s.nClauses();
+            preprocessFormula(s, m_layout);
+            m_log << "Info: preprocessing eliminated " << s.eliminated_vars << " of " << s.nVars() << " variables and reduced "
+                  << clauses << " to " << s.nClauses() << " clauses" << std::endl;
+        }
+        m_log << "Info: the solver keeps " << s.nClauses() << " of the " << m_formulaClauses << " clauses (" << s.nAssigns()
+              << " fixed variables)" << std::endl;
+    }
+    else
     {
-        s.addClause(w2lit(wall));
+        m_log << "Info: reusing the solver of the previous puzzle" << std::endl;
     }
-    for (auto wall: m_template.getFixedOpenWalls())
+
+    if (m_reuse)
     {
-        s.addClause(~w2lit(wall));
+        // retire the clauses of the previous puzzle
+        if (m_activation != Minisat::lit_Undef) s.addClause(~m_activation);
+        m_activation = Minisat::mkLit(s.newVar());
     }
 
+    m_log << "Info: SAT encoding (" << toString(m_options.pathEncoding) << ") has " << m_formulaVars << " variables and " << m_formulaClauses << " clauses" << std::endl;
+    if (m_stats.foldedClauses > 0)
+    {
+        m_log << "Info: the template's fixed walls are constants, " << m_stats.foldedClauses << " clauses they satisfy are left out" << std::endl;
+    }
+    if (m_options.pathEncoding == PathEncoding::Position)
+    {
+        m_log << "Info: exactly-one constraints (fields: " << toString(m_options.fieldAmo) << ", positions: " << toString(m_options.positionAmo) << ") use "
+                  << m_stats.cardinalityVariables << " variables and " << m_stats.cardinalityClauses << " clauses" << std::endl;
+        m_log << "Info: presolve pruned " << m_stats.prunedVariables << " of " << (w() * h() * w() * h()) << " position variables" << std::endl;
+    }
+
+    m_log << "Info: creating initial path" << std::flush;
+
     // find initial path in empty board with random fixed entry/exit
     for (int count = 0; /**/; ++count)
     {
@@ -91,44 +186,42 @@ Board Generator::get()
             field1 = c2f(choice(edgeFields));
             field2 = c2f(choice(edgeFields));
         }
-        initialAssumptions.push(fp2lit(std::min(field1, field2), 0));
-        initialAssumptions.push(fp2lit(std::max(field1, field2), pathLength-1));
+        orderEnds(m_layout, field1, field2);
+        const auto entry = m_layout.entryLit(field1);
+        const auto exit = m_layout.exitLit(field2);
 
-        for (auto wall: m_template.getPossibleWalls())
+        // the presolve has no variables for impossible entry/exit fields
+        if (entry != Minisat::lit_Undef && exit != Minisat::lit_Undef)
         {
-            initialAssumptions.push(~w2lit(wall));
-        }
+            initialAssumptions.push(entry);
+            initialAssumptions.push(exit);
+
+            for (auto wall: m_template.getPossibleWalls())
+            {
+                initialAssumptions.push(~m_layout.wall(wall));
+            }
 
-        if (s.solve(initialAssumptions)) break;
+            if (cancelled()) return GeneratorResult();
+            const Minisat::lbool result = solve(s, initialAssumptions, "initial");
+            if (result == l_Undef) return GeneratorResult();
+            if (result == l_True) break;
+        }
 
         if (count > 100)
         {
-            std::cout << "\nError: cannot find initial path within 100 tries. Check template!" << std::endl;
-            return Board();
+            m_log << "\nError: cannot find initial path within 100 tries. Check template!" << std::endl;
+            return GeneratorResult();
         }
     }
     
     // extract initialPath
-    Path initialPath(pathLength);
-    Minisat::vec<Minisat::Lit> pathClause;
-    for (int field = 0; field < pathLength; ++field)
-    {
-        for (int pos = 0; pos < pathLength; ++pos)
-        {
-            const auto lit = fp2lit(field, pos);
-            const Minisat::lbool value = s.modelValue(lit);
-                
-            if (Minisat::toInt(value) == 0 /* = Minisat::l_True */)
-            {
-                initialPath.set(pos, f2c(field));
-                pathClause.push(~lit);
-            }
-        }
-    }
-    std::cout << "\rInfo: initial path created                     " << std::endl;
+    const Path initialPath = extractPath(s, m_layout);
+    m_log << "\rInfo: initial path created                     " << std::endl;
 
     // initialPath is forbidden
-    s.addClause(pathClause);
+    Minisat::vec<Minisat::Lit> blockingClause;
+    pathClause(m_layout, initialPath, blockingClause);
+    addPuzzleClause(s, blockingClause);
         
     std::set<Wall> fixedClosedWalls = m_template.getFixedClosedWalls();
     std::set<Wall> fixedOpenWalls = m_template.getFixedOpenWalls();
@@ -155,7 +248,7 @@ Board Generator::get()
             if (fixedOpenWalls.find(w) == fixedOpenWalls.end())
             {
                 fixedOpenWalls.insert(w);
-                s.addClause(~w2lit(w));
+                addPuzzleClause(s, ~m_layout.wall(w));
             }
         }
     }
@@ -165,23 +258,26 @@ Board Generator::get()
         Minisat::vec<Minisat::Lit> assumptions;
         for (auto w: possibleWalls)
         {
-            assumptions.push(w2lit(w));
+            assumptions.push(m_layout.wall(w));
         }
-        if (!s.solve(assumptions))
+        if (cancelled()) return GeneratorResult();
+        const Minisat::lbool result = solve(s, assumptions, "lift");
+        if (result == l_Undef) return GeneratorResult();
+        if (result == l_False)
         {
-            getConflictSet(s.conflict, conflict);
+            getConflictSet(s.conflict, s.nVars(), conflict);
 
             for (auto it = possibleWalls.begin(); it != possibleWalls.end(); /**/)
             {
-                const auto lit = w2lit(*it);
-                if (conflict.find(Minisat::toInt(~lit)) != conflict.end())
+                const auto lit = m_layout.wall(*it);
+                if (conflict[Minisat::toInt(~lit)])
                 {
                     ++it;
                 }
                 else
                 {
                     fixedOpenWalls.insert(*it);
-                    s.addClause(~lit);
+                    addPuzzleClause(s, ~lit);
                     it = possibleWalls.erase(it);
                 }
             }
@@ -189,103 +285,152 @@ Board Generator::get()
     }
 
     // iteratively add non-blocking walls until the initial path is unique (after adding *all* non-blocking walls, the initial path is guaranteed to be unique)
-    std::cout << "\rInfo: adding walls...                     " << std::flush;
+    m_log << "\rInfo: adding walls...                     " << std::flush;
     std::vector<Wall> candidateClosedWalls;
+    // alternative path of the last satisfiable query (if blocking alternatives)
+    Path alternativePath;
+    // number of added walls at the next backbone probe (doubled after each)
+    unsigned int nextBackbone = 8;
+    if (m_quickXplain)
+    {
+        // QuickXplain searches all possible walls at once; closing all of them makes the initial path unique
+        candidateClosedWalls.swap(possibleWalls);
+    }
     while (!possibleWalls.empty())
     {
+        if (m_backbone && candidateClosedWalls.size() >= nextBackbone)
+        {
+            if (!pruneByBackbone(s, possibleWalls, candidateClosedWalls, fixedOpenWalls)) return GeneratorResult();
+            nextBackbone *= 2;
+            if (possibleWalls.empty()) break;
+        }
         Minisat::vec<Minisat::Lit> assumptions;
 
-        const Wall wall = takeChoice(possibleWalls);
-        const auto lit = w2lit(wall);
+        const Wall wall = alternativePath.isEmpty() ? takeChoice(possibleWalls) : takeBlockingChoice(possibleWalls, alternativePath);
+        const auto lit = m_layout.wall(wall);
         assumptions.push(lit);
         for (auto w: candidateClosedWalls)
         {
-            assumptions.push(w2lit(w));
+            assumptions.push(m_layout.wall(w));
         }
         for (auto w: possibleWalls)
         {
-            assumptions.push(~w2lit(w));
+            assumptions.push(~m_layout.wall(w));
         }
         
         candidateClosedWalls.push_back(wall);
-        std::cout << "\rInfo: adding wall #" << candidateClosedWalls.size() << ", remaining " << possibleWalls.size() << "                     " << std::flush;
+        m_log << "\rInfo: adding wall #" << candidateClosedWalls.size() << ", remaining " << possibleWalls.size() << "                     " << std::flush;
 
-        if (!s.solve(assumptions))
+        if (cancelled()) return GeneratorResult();
+        const Minisat::lbool result = solve(s, assumptions, "add");
+        if (result == l_Undef) return GeneratorResult();
+        if (result == l_False)
         {
             // initial path became unique
 
-            getConflictSet(s.conflict, conflict);
+            getConflictSet(s.conflict, s.nVars(), conflict);
             
             // conflict clause based lifting
             for (auto it = candidateClosedWalls.begin(); it != candidateClosedWalls.end(); /**/)
             {
-                const auto lit = w2lit(*it);
-                if (conflict.find(Minisat::toInt(~lit)) != conflict.end())
+                const auto lit = m_layout.wall(*it);
+                if (conflict[Minisat::toInt(~lit)])
                 {
                     ++it;
                 }
                 else
                 {
                     fixedOpenWalls.insert(*it);
-                    s.addClause(~lit);
+                    addPuzzleClause(s, ~lit);
                     it = candidateClosedWalls.erase(it);
                 }
             }
             
             break;
         }
+
+        if (m_blockAlternatives)
+        {
+            alternativePath = extractPath(s, m_layout);
+        }
     }
-    std::cout << "\rInfo: added walls => walls=" << candidateClosedWalls.size() << "                            " << std::endl;
+    m_log << "\rInfo: added walls => walls=" << candidateClosedWalls.size() << "                            " << std::endl;
     
-    std::cout << "\rInfo: removing non-essential walls...                     " << std::flush;
+    m_log << "\rInfo: removing non-essential walls...                     " << std::flush;
+    if (m_speculate > 1 && !removeWallsSpeculatively(s, candidateClosedWalls, fixedClosedWalls, fixedOpenWalls))
+    {
+        return GeneratorResult();
+    }
+    if (m_quickXplain && !removeWallsQuickXplain(s, candidateClosedWalls, fixedClosedWalls, fixedOpenWalls))
+    {
+        return GeneratorResult();
+    }
     while (!candidateClosedWalls.empty())
     {
-        std::cout << "\rInfo: removing walls... " << candidateClosedWalls.size() << "                     " << std::flush;
+        m_log << "\rInfo: removing walls... " << candidateClosedWalls.size() << "                     " << std::flush;
         Minisat::vec<Minisat::Lit> assumptions;
         
         const Wall wall = takeChoice(candidateClosedWalls);
-        const auto lit = w2lit(wall);
+        const auto lit = m_layout.wall(wall);
         assumptions.push(~lit);
         for (auto w: candidateClosedWalls)
         {
-            assumptions.push(w2lit(w));
+            assumptions.push(m_layout.wall(w));
         }
         
-        if (s.solve(assumptions))
+        if (cancelled()) return GeneratorResult();
+        const Minisat::lbool result = solve(s, assumptions, "remove");
+        if (result == l_Undef) return GeneratorResult();
+        if (result == l_True)
         {
             // wall is needed to keep path unique -> fix variable=1
-            s.addClause(lit);
+            addPuzzleClause(s, lit);
             fixedClosedWalls.insert(wall);
         }
         else
         {
-            getConflictSet(s.conflict, conflict);
+            getConflictSet(s.conflict, s.nVars(), conflict);
 
             // conflict clause based lifting
             for (auto it = candidateClosedWalls.begin(); it != candidateClosedWalls.end(); /**/)
             {
-                const auto lit = w2lit(*it);
-                if (conflict.find(Minisat::toInt(~lit)) != conflict.end())
+                const auto lit = m_layout.wall(*it);
+                if (conflict[Minisat::toInt(~lit)])
                 {
                     ++it;
                 }
                 else
                 {
                     fixedOpenWalls.insert(*it);
-                    s.addClause(~lit);
+                    addPuzzleClause(s, ~lit);
                     it = candidateClosedWalls.erase(it);
                 }
             }
 
             // wall can be removed -> fix variable=0
             fixedOpenWalls.insert(wall);
-            s.addClause(~lit);
+            addPuzzleClause(s, ~lit);
         }
     }
-    std::cout << "\rInfo: removed non-essential walls => walls=" << fixedClosedWalls.size() << "                     " << std::endl;
+    m_log << "\rInfo: removed non-essential walls => walls=" << fixedClosedWalls.size() << "                     " << std::endl;
+    m_log << "Info: solver statistics: " << s.conflicts << " conflicts, " << s.decisions << " decisions, " << s.propagations << " propagations" << std::endl;
+    if (m_query.portfolio().size() > 1 && m_query.portfolio().mode() != Portfolio::Mode::Alone)
+    {
+        m_log << ((m_query.portfolio().mode() == Portfolio::Mode::Cubes) ? "Info: cubes solved per solver:" : "Info: portfolio wins:");
+        for (int i = 0; i < m_query.portfolio().size(); ++i)
+        {
+            m_log << " " << m_query.portfolio().wins(i);
+        }
+        m_log << std::endl;
+    }
 
-    // create final board
-    Board b(w(), h());
+    // create final board; the initial path is unique as long as the fixed closed walls are present
+    if (cancelled()) return GeneratorResult();
+    GeneratorResult result;
+    result.board = Board(w(), h());
+    result.certificate.path = initialPath;
+    result.certificate.walls = fixedClosedWalls;
+    Board& b = result.board;
     for (auto wall: fixedClosedWalls)
     {
         b.addWall(wall);
@@ -317,13 +462,411 @@ Board Generator::get()
         b.addWall(takeChoice(walls));
     }
 
-    return b;
+    return result;
+}
+
+void Generator::cancel()
+{
+    m_cancelled = true;
+    std::lock_guard<std::mutex> lock(m_solverMutex);
+    if (m_solver) m_solver->interrupt();
+    m_query.interrupt();
+}
+
+
+bool Generator::cancelled()
+{
+    if (m_cancelled)
+    {
+        m_log << "\nInfo: generation cancelled" << std::endl;
+    }
+    return m_cancelled;
+}
+
+
+// Finds a minimal set of candidate walls that keeps the initial path unique by QuickXplain: if the walls closed so
+// far do not suffice, the candidates are split in halves, and the halves are only searched further if they are
+// needed. With k needed walls out of n candidates this takes O(k log(n/k)) queries, so it runs on all possible walls
+// instead of after the wall-adding phase. Closing more walls only removes paths, so the result is minimal just like
+// the one-by-one removal. Returns false if cancelled.
+bool Generator::removeWallsQuickXplain(SatSolver& s, std::vector<Wall>& candidateClosedWalls, std::set<Wall>& fixedClosedWalls, std::set<Wall>& fixedOpenWalls)
+{
+    if (candidateClosedWalls.empty())
+    {
+        return true;
+    }
+    std::shuffle(candidateClosedWalls.begin(), candidateClosedWalls.end(), m_rng);
+
+    std::vector<Wall> needed;
+    if (!quickXplain(s, candidateClosedWalls, std::vector<Wall>(), true, candidateClosedWalls, needed))
+    {
+        return false;
+    }
+
+    const std::set<Wall> neededSet(needed.begin(), needed.end());
+    for (auto w: candidateClosedWalls)
+    {
+        const auto lit = m_layout.wall(w);
+        if (neededSet.find(w) != neededSet.end())
+        {
+            fixedClosedWalls.insert(w);
+            addPuzzleClause(s, lit);
+        }
+        else
+        {
+            fixedOpenWalls.insert(w);
+            addPuzzleClause(s, ~lit);
+        }
+    }
+    candidateClosedWalls.clear();
+    return true;
 }
 
-void Generator::getConflictSet(const Minisat::vec<Minisat::Lit>& conflictVec, std::unordered_set<int>& conflictSet) const
+
+// Appends to `needed` a minimal subset of `walls` that keeps the initial path unique together with the `closed`
+// walls, all other candidates open; `closed` and all of `walls` together are known to keep it unique. If `test` is
+// set, `closed` alone is tried first; if it suffices, the walls of `closed` in the solver's core are stored in `core`
+// (if given). Returns false if cancelled.
+bool Generator::quickXplain(SatSolver& s, const std::vector<Wall>& candidates, const std::vector<Wall>& closed, bool test, const std::vector<Wall>& walls, std::vector<Wall>& needed,
+                            std::vector<Wall>* core)
+{
+    if (test)
+    {
+        m_log << "\rInfo: removing walls... needed " << needed.size() << ", testing " << walls.size() << "                     " << std::flush;
+
+        const std::set<Wall> closedSet(closed.begin(), closed.end());
+        Minisat::vec<Minisat::Lit> assumptions;
+        for (auto w: candidates)
+        {
+            const auto lit = m_layout.wall(w);
+            assumptions.push((closedSet.find(w) != closedSet.end()) ? lit : ~lit);
+        }
+
+        if (cancelled()) return false;
+        const Minisat::lbool result = solve(s, assumptions, "remove");
+        if (result == l_Undef) return false;
+        if (result == l_False)
+        {
+            if (core != nullptr)
+            {
+                std::vector<bool> conflict;
+                getConflictSet(s.conflict, s.nVars(), conflict);
+                for (auto w: closed)
+                {
+                    if (conflict[Minisat::toInt(~m_layout.wall(w))]) core->push_back(w);
+                }
+            }
+            return true;
+        }
+    }
+
+    if (walls.size() == 1)
+    {
+        needed.push_back(walls[0]);
+        return true;
+    }
+
+    const auto middle = walls.begin() + walls.size() / 2;
+    std::vector<Wall> walls1(walls.begin(), middle);
+    const std::vector<Wall> walls2(middle, walls.end());
+
+    // the needed walls of the second half, with all of the first half closed
+    std::vector<Wall> closed1 = closed;
+    closed1.insert(closed1.end(), walls1.begin(), walls1.end());
+    std::vector<Wall> needed2;
+    std::vector<Wall> core1;
+    if (!quickXplain(s, candidates, closed1, true, walls2, needed2, &core1)) return false;
+
+    if (needed2.empty())
+    {
+        // refinement: the first half is only searched within the core of the query that made the second half obsolete
+        const std::set<Wall> coreSet(core1.begin(), core1.end());
+        walls1.erase(std::remove_if(walls1.begin(), walls1.end(), [&](const Wall& w) { return coreSet.find(w) == coreSet.end(); }), walls1.end());
+        if (walls1.empty())
+        {
+            return true;
+        }
+    }
+
+    // the needed walls of the first half, with only the needed walls of the second half closed
+    std::vector<Wall> closed2 = closed;
+    closed2.insert(closed2.end(), needed2.begin(), needed2.end());
+    std::vector<Wall> needed1;
+    if (!quickXplain(s, candidates, closed2, !needed2.empty(), walls1, needed1)) return false;
+
+    needed.insert(needed.end(), needed1.begin(), needed1.end());
+    needed.insert(needed.end(), needed2.begin(), needed2.end());
+    return true;
+}
+
+
+// Tests the next m_speculate removal candidates at once, each on its own solver with all other candidates closed, and
+// commits the outcomes in the order the candidates were drawn. A needed wall stays needed when earlier commits open
+// walls (opening walls only adds paths), but a removable wall was only shown removable with the walls closed that an
+// earlier commit of the same round may have opened; such outcomes are discarded and the wall is tested again.
+// Returns false if cancelled.
+bool Generator::removeWallsSpeculatively(SatSolver& s, std::vector<Wall>& candidateClosedWalls, std::set<Wall>& fixedClosedWalls, std::set<Wall>& fixedOpenWalls)
+{
+    std::vector<bool> conflict;
+    while (!candidateClosedWalls.empty())
+    {
+        m_log << "\rInfo: removing walls... " << candidateClosedWalls.size() << "                     " << std::flush;
+
+        std::vector<Wall> round;
+        while (static_cast<int>(round.size()) < m_speculate && !candidateClosedWalls.empty())
+        {
+            round.push_back(takeChoice(candidateClosedWalls));
+        }
+
+        std::vector<std::vector<Minisat::Lit>> queries(round.size());
+        for (unsigned int i = 0; i < round.size(); ++i)
+        {
+            queries[i].push_back(~m_layout.wall(round[i]));
+            for (unsigned int j = 0; j < round.size(); ++j)
+            {
+                if (j != i) queries[i].push_back(m_layout.wall(round[j]));
+            }
+            for (auto w: candidateClosedWalls)
+            {
+                queries[i].push_back(m_layout.wall(w));
+            }
+            if (m_activation != Minisat::lit_Undef) queries[i].push_back(m_activation);
+        }
+
+        if (cancelled()) return false;
+        std::vector<Minisat::lbool> results;
+        std::vector<std::vector<Minisat::Lit>> conflicts;
+        m_query.solveEach(s, m_layout, queries, "remove", results, conflicts);
+        for (auto result: results)
+        {
+            if (result == l_Undef)
+            {
+                m_log << "\nInfo: generation cancelled" << std::endl;
+                return false;
+            }
+        }
+
+        bool opened = false;
+        for (unsigned int i = 0; i < round.size(); ++i)
+        {
+            const Wall wall = round[i];
+            const auto lit = m_layout.wall(wall);
+            if (fixedOpenWalls.find(wall) != fixedOpenWalls.end())
+            {
+                // opened by the lifting of an earlier commit
+                continue;
+            }
+
+            if (results[i] == l_True)
+            {
+                // wall is needed to keep path unique -> fix variable=1
+                addPuzzleClause(s, lit);
+                fixedClosedWalls.insert(wall);
+            }
+            else if (opened)
+            {
+                // tested with a wall closed that is open now
+                candidateClosedWalls.push_back(wall);
+            }
+            else
+            {
+                conflict.assign(2 * s.nVars(), false);
+                for (auto l: conflicts[i])
+                {
+                    conflict[Minisat::toInt(l)] = true;
+                }
+
+                // conflict clause based lifting, also of the round's later walls
+                for (auto it = candidateClosedWalls.begin(); it != candidateClosedWalls.end(); /**/)
+                {
+                    const auto lit = m_layout.wall(*it);
+                    if (conflict[Minisat::toInt(~lit)])
+                    {
+                        ++it;
+                    }
+                    else
+                    {
+                        fixedOpenWalls.insert(*it);
+                        addPuzzleClause(s, ~lit);
+                        it = candidateClosedWalls.erase(it);
+                    }
+                }
+                for (unsigned int j = i + 1; j < round.size(); ++j)
+                {
+                    const auto lit = m_layout.wall(round[j]);
+                    if (!conflict[Minisat::toInt(~lit)])
+                    {
+                        fixedOpenWalls.insert(round[j]);
+                        addPuzzleClause(s, ~lit);
+                    }
+                }
+
+                // wall can be removed -> fix variable=0
+                fixedOpenWalls.insert(wall);
+                addPuzzleClause(s, ~lit);
+                opened = true;
+            }
+        }
+    }
+    return true;
+}
+
+
+// Finds the possible walls that no alternative path crosses, with the candidate walls closed and the possible walls
+// open. Such walls are useless now and, since adding walls only removes paths, later on as well; they are fixed open
+// at once. Instead of one query per wall, each query asks for a path crossing any of the walls no path crossed so far
+// (a clause guarded by a fresh activation literal): a model rules out all the walls its path crosses, and the first
+// unsatisfiable query proves all remaining walls unused. Edge encoding only (the crossed wall positions are variables
+// there). Returns false if cancelled.
+bool Generator::pruneByBackbone(SatSolver& s, std::vector<Wall>& possibleWalls, const std::vector<Wall>& candidateClosedWalls, std::set<Wall>& fixedOpenWalls)
+{
+    Minisat::vec<Minisat::Lit> assumptions;
+    for (auto w: candidateClosedWalls)
+    {
+        assumptions.push(m_layout.wall(w));
+    }
+    for (auto w: possibleWalls)
+    {
+        assumptions.push(~m_layout.wall(w));
+    }
+    assumptions.push(Minisat::lit_Undef);
+
+    // walls not crossed by any alternative path so far
+    std::vector<Wall> uncrossed = possibleWalls;
+    for (int round = 1; !uncrossed.empty(); ++round)
+    {
+        m_log << "\rInfo: probing backbone... round " << round << ", uncrossed " << uncrossed.size() << "                     " << std::flush;
+
+        const auto activation = Minisat::mkLit(s.newVar());
+        Minisat::vec<Minisat::Lit> clause;
+        clause.push(~activation);
+        for (auto w: uncrossed)
+        {
+            clause.push(~m_layout.edge(w));
+        }
+        s.addClause(clause);
+        assumptions.last() = activation;
+
+        if (cancelled()) return false;
+        const Minisat::lbool crossed = solve(s, assumptions, "backbone");
+        // retire the activation literal
+        s.addClause(~activation);
+        if (crossed == l_Undef)
+        {
+            return false;
+        }
+        if (crossed == l_False)
+        {
+            break;
+        }
+
+        std::vector<Wall> remaining;
+        for (auto w: uncrossed)
+        {
+            // edge(w) is false if the path crosses w
+            if (Minisat::toInt(s.modelValue(m_layout.edge(w))) == 0 /* = Minisat::l_True */)
+            {
+                remaining.push_back(w);
+            }
+        }
+        uncrossed.swap(remaining);
+    }
+
+    const std::set<Wall> unused(uncrossed.begin(), uncrossed.end());
+    std::vector<Wall> remaining;
+    for (auto w: possibleWalls)
+    {
+        if (unused.find(w) != unused.end())
+        {
+            fixedOpenWalls.insert(w);
+            addPuzzleClause(s, ~m_layout.wall(w));
+        }
+        else
+        {
+            remaining.push_back(w);
+        }
+    }
+    possibleWalls.swap(remaining);
+    m_log << "\rInfo: backbone: no alternative path crosses " << unused.size() << " walls, remaining " << possibleWalls.size() << "                     " << std::endl;
+    return true;
+}
+
+
+// Takes a random wall that blocks the path, or any random wall if none does. The alternative path of a satisfiable
+// query is blocked by one of the remaining possible walls (closing all of them makes the initial path unique), so
+// adding such a wall rules out at least that path, while a random wall often leaves it open.
+Wall Generator::takeBlockingChoice(std::vector<Wall>& walls, const Path& path)
+{
+    std::vector<int> blocking;
+    for (unsigned int i = 0; i < walls.size(); ++i)
+    {
+        if (path.isBlockedBy(walls[i]))
+        {
+            blocking.push_back(i);
+        }
+    }
+    if (blocking.empty())
+    {
+        return takeChoice(walls);
+    }
+
+    const int index = choice(blocking);
+    const Wall wall = walls[index];
+    std::swap(walls[index], walls.back());
+    walls.pop_back();
+    return wall;
+}
+
+
+Minisat::lbool Generator::solve(SatSolver& s, const Minisat::vec<Minisat::Lit>& assumptions, const std::string& stage)
+{
+    Minisat::lbool result;
+    if (m_activation == Minisat::lit_Undef)
+    {
+        result = m_query.solve(s, m_layout, assumptions, stage);
+    }
+    else
+    {
+        Minisat::vec<Minisat::Lit> activated;
+        assumptions.copyTo(activated);
+        activated.push(m_activation);
+        result = m_query.solve(s, m_layout, activated, stage);
+    }
+
+    // an interrupted query has no answer (its conflict is empty): the caller gives up at once
+    if (result == l_Undef)
+    {
+        m_log << "\nInfo: generation cancelled" << std::endl;
+    }
+    return result;
+}
+
+
+void Generator::addPuzzleClause(SatSolver& s, Minisat::vec<Minisat::Lit>& clause)
+{
+    if (m_activation != Minisat::lit_Undef) clause.push(~m_activation);
+    s.addClause(clause);
+}
+
+
+void Generator::addPuzzleClause(SatSolver& s, Minisat::Lit lit)
+{
+    if (m_activation != Minisat::lit_Undef)
+    {
+        s.addClause(~m_activation, lit);
+    }
+    else
+    {
+        s.addClause(lit);
+    }
+}
+
+
+void Generator::getConflictSet(const Minisat::vec<Minisat::Lit>& conflictVec, int vars, std::vector<bool>& conflictSet) const
 {
-    conflictSet.clear();
+    // indexed by Minisat::toInt(lit)
+    conflictSet.assign(2 * vars, false);
     for (int i = 0; i < conflictVec.size(); ++i) {
-        conflictSet.insert(Minisat::toInt(conflictVec[i]));
+        conflictSet[Minisat::toInt(conflictVec[i])] = true;
     }
 }
@@ -24,44 +24,126 @@
 
 #pragma once
 
+#include <atomic>
 #include <cassert>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
 #include <random>
-#include <unordered_set>
+#include <set>
+#include <string>
 #include <utility>
 #include <vector>
 
 #include <core/SolverTypes.h>
 
 #include "board.h"
+#include "clauseSink.h"
+#include "dimacs.h"
+#include "formula.h"
+#include "path.h"
+#include "satSolver.h"
 #include "templateBoard.h"
 
+// Seed of puzzle `index` of a batch with the given master seed (splitmix64 over both), never 0. The puzzle does not
+// depend on the other puzzles of the batch or on the order they run in; `--seed <derived seed>` generates it alone.
+unsigned int deriveSeed(unsigned int master, unsigned int index);
+
+
+// Formula built (or loaded from the cache) once and shared read-only by several generators.
+struct PreparedFormula
+{
+    ClauseBuffer clauses;
+    FormulaLayout layout;
+    FormulaStats stats;
+};
+
+// Builds (or loads) the template's formula once; each generator adds its clauses to its own solver and preprocesses them there.
+void prepareFormula(const TemplateBoard& templateBoard, const FormulaOptions& options, const std::string& cacheDirectory, PreparedFormula& formula,
+                    std::ostream& log);
+
+
+// A generated board and the generator's proof that its path is the only solution.
+struct GeneratorResult
+{
+    Board board;
+    SolutionCertificate certificate;
+};
+
+
 class Generator
 {
     public:
-      Generator(const TemplateBoard& templateBoard, unsigned int seed);
+      Generator(const TemplateBoard& templateBoard, const FormulaOptions& options, const DimacsOptions& dimacs, const SolverOptions& solver, const std::string& cacheDirectory, unsigned int seed,
+                std::ostream& log);
+
+      // use the prepared formula instead of building one in get(); it must outlive the generator
+      void setFormula(const PreparedFormula* formula) { m_formula = formula; }
 
-      Board get();
+      // seed of the next get() (0: random)
+      void setSeed(unsigned int seed);
+      // dump/import files of the next get()'s queries, numbered from 0 again
+      void setDimacs(const DimacsOptions& dimacs) { m_query.setOptions(dimacs); }
+
+      // If the solver is reused (SolverOptions::reuse), consecutive calls share one solver and its learnt clauses:
+      // the clauses of each puzzle are guarded by an activation literal that is assumed in the puzzle's queries and
+      // retired (set false) when the next puzzle starts.
+      GeneratorResult get();
+
+      // Make a running get() return an empty result soon (from any thread): the running solver query is interrupted,
+      // which makes get() return at once, and get() checks for cancellation before every query.
+      void cancel();
 
     private:
+      bool cancelled();
+
       int w() const { return m_template.width(); }
       int h() const { return m_template.height(); }
 
       int c2f(const Coordinates& c) const { return c.x() + w() * c.y(); }
       Coordinates f2c(int f) const { return {f%w(), f/w()}; }
 
-      Minisat::Lit fp2lit(int f, int p) const { auto it = m_fp2lit.find({f, p}); return (it != m_fp2lit.end()) ? it->second : Minisat::Lit(); }
-      Minisat::Lit w2lit(const Wall& wall) const { auto it = m_w2lit.find(wall); return (it != m_w2lit.end()) ? it->second : Minisat::Lit(); }
+      // query with the puzzle's activation literal (l_Undef if interrupted by cancel()); clause of the current puzzle only
+      Minisat::lbool solve(SatSolver& s, const Minisat::vec<Minisat::Lit>& assumptions, const std::string& stage);
+      void addPuzzleClause(SatSolver& s, Minisat::vec<Minisat::Lit>& clause);
+      void addPuzzleClause(SatSolver& s, Minisat::Lit lit);
 
-      void getConflictSet(const Minisat::vec<Minisat::Lit>& conflictVec, std::unordered_set<int>& conflictSet) const;
+      void getConflictSet(const Minisat::vec<Minisat::Lit>& conflictVec, int vars, std::vector<bool>& conflictSet) const;
+      bool removeWallsQuickXplain(SatSolver& s, std::vector<Wall>& candidateClosedWalls, std::set<Wall>& fixedClosedWalls, std::set<Wall>& fixedOpenWalls);
+      bool quickXplain(SatSolver& s, const std::vector<Wall>& candidates, const std::vector<Wall>& closed, bool test, const std::vector<Wall>& walls, std::vector<Wall>& needed,
+                       std::vector<Wall>* core = nullptr);
+      bool removeWallsSpeculatively(SatSolver& s, std::vector<Wall>& candidateClosedWalls, std::set<Wall>& fixedClosedWalls, std::set<Wall>& fixedOpenWalls);
       template<typename T> const T& choice(const std::vector<T>& v);
       template<typename T> T takeChoice(std::vector<T>& v);
+      bool pruneByBackbone(SatSolver& s, std::vector<Wall>& possibleWalls, const std::vector<Wall>& candidateClosedWalls, std::set<Wall>& fixedOpenWalls);
+      Wall takeBlockingChoice(std::vector<Wall>& walls, const Path& path);
 
     private:
       std::mt19937 m_rng;
       TemplateBoard m_template;
-      std::map<std::pair<int, int>, Minisat::Lit> m_fp2lit;
-      std::map<Wall, Minisat::Lit> m_w2lit;
+      FormulaOptions m_options;
+      std::string m_cacheDirectory;
+      int m_speculate;
+      bool m_blockAlternatives;
+      bool m_quickXplain;
+      bool m_backbone;
+      bool m_reuse;
+      bool m_preprocess;
+      const PreparedFormula* m_formula = nullptr;
+      std::ostream& m_log;
+      FormulaLayout m_layout;
+      FormulaStats m_stats;
+      int m_formulaVars = 0;
+      int m_formulaClauses = 0;
+      // activation literal of the current puzzle's clauses (lit_Undef unless reusing the solver)
+      Minisat::Lit m_activation = Minisat::lit_Undef;
+      QuerySolver m_query;
+
+      std::atomic<bool> m_cancelled;
+      // solver of the running get(); the mutex guards replacing it against cancel()
+      std::mutex m_solverMutex;
+      std::unique_ptr<SatSolver> m_solver;
 };
 
 
@@ -22,11 +22,12 @@
 * SOFTWARE.
 *******************************************************************************/
 
-#include <fstream>
 #include <iostream>
+#include "batch.h"
 #include "board.h"
 #include "commandline.h"
 #include "generator.h"
+#include "race.h"
 #include "templateBoard.h"
 
 
@@ -38,18 +39,21 @@ int main(int argc, char** argv)
         return 1;
     }
     
-    TemplateBoard templateBoard;
-    if (!options.templateFile.empty())
+    if (!options.manifest.empty())
     {
-        std::ifstream file(options.templateFile);
-        if (!file)
+        Batch batch;
+        if (!readManifest(options.manifest, batch))
         {
-            std::cout << "Error: cannot open template file '" << options.templateFile << "' for reading" << std::endl;
             return 1;
         }
-        if (!templateBoard.parse(file))
+        return runBatch(batch, options, std::cout) ? 0 : 1;
+    }
+
+    TemplateBoard templateBoard;
+    if (!options.templateFile.empty())
+    {
+        if (!readTemplateFile(options.templateFile, templateBoard))
         {
-            std::cout << "Error: syntax error in template file '" << options.templateFile << "'" << std::endl;
             return 1;
         }
     }
@@ -60,33 +64,33 @@ int main(int argc, char** argv)
 
     std::cout << templateBoard << std::endl;
 
-    const Board b = Generator(templateBoard, options.seed).get();
+    if (options.count > 1)
+    {
+        return generateBatch(templateBoard, options, std::cout) ? 0 : 1;
+    }
+
+    GeneratorResult result;
+    if (options.race > 1)
+    {
+        result = race(templateBoard, options, std::cout);
+    }
+    else
+    {
+        // the same formula setup as batch and race, so that their puzzles' seeds reproduce them here
+        PreparedFormula formula;
+        prepareFormula(templateBoard, options.formula, options.formulaCache, formula, std::cout);
+        Generator generator(templateBoard, options.formula, options.dimacs, options.solver, options.formulaCache, options.seed, std::cout);
+        generator.setFormula(&formula);
+        result = generator.get();
+    }
+    const Board& b = result.board;
     std::cout << b << std::endl;
     
     if (options.solve)
     {
         std::cout << "Computing solution..." << std::endl;
-        std::tuple<bool, bool, Path> solution = b.solve();
-        if (std::get<0>(solution))
-        {
-            std::cout << "Board is solvable" << std::endl;
-            
-            if (std::get<1>(solution))
-            {
-                std::cout << "Board is uniquely solvable" << std::endl;
-            }
-            else
-            {
-                std::cout << "Board is NOT uniquely solvable" << std::endl;
-            }
-            
-            std::cout << "Solution:" << std::endl;
-            b.print(std::cout, std::get<2>(solution));
-        }
-        else
-        {
-            std::cout << "Board is NOT solvable" << std::endl;
-        }
+        const std::tuple<bool, bool, Path> solution = b.solve(options.formula, options.dimacs, options.solver, options.formulaCache, std::cout, &result.certificate);
+        printSolution(std::cout, b, solution);
     }
         
     return 0;
@@ -0,0 +1,301 @@
+/*******************************************************************************
+* alcazar-gen
+*
+* Copyright (c) 2015 Florian Pigorsch
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+
+#include "portfolio.h"
+
+
+Portfolio::Portfolio(int size, Mode mode) :
+    m_mode(mode),
+    m_wins(std::max(size, 1), 0)
+{
+    for (int i = 1; i < size; ++i)
+    {
+        std::unique_ptr<SatSolver> copy(new SatSolver());
+        // the copies never preprocess; without elimination they keep no occurrence lists for the synchronized clauses
+        copy->disablePreprocessing();
+
+        // the solver itself keeps the default configuration; each copy varies all heuristics
+        copy->random_seed = 91648253 + 7919 * i;
+        copy->rnd_init_act = true;
+        copy->random_var_freq = 0.01 * (i % 3);
+        copy->phase_saving = i % 3;
+        copy->luby_restart = (i % 2 == 0);
+        copy->restart_first = 50 * (1 + i % 4);
+        m_copies.push_back(std::move(copy));
+    }
+}
+
+
+void Portfolio::synchronize(const SatSolver& s)
+{
+    const ClauseBuffer& formula = s.recorded();
+    Minisat::vec<Minisat::Lit> clause;
+    for (auto& copy: m_copies)
+    {
+        while (copy->nVars() < s.nVars())
+        {
+            copy->newVar();
+        }
+        for (int c = m_synchronized; c < formula.size(); ++c)
+        {
+            clause.clear();
+            for (int i = 0; i < formula.clauseSize(c); ++i)
+            {
+                clause.push(formula.clause(c)[i]);
+            }
+            copy->addClause(clause);
+        }
+    }
+    m_synchronized = formula.size();
+}
+
+
+void Portfolio::interrupt()
+{
+    for (auto& copy: m_copies)
+    {
+        copy->interrupt();
+    }
+}
+
+
+Minisat::lbool Portfolio::solve(SatSolver& s, const FormulaLayout& layout, const Minisat::vec<Minisat::Lit>& assumptions)
+{
+    if (m_copies.empty() || m_mode == Mode::Alone)
+    {
+        return solvePath(s, layout, assumptions);
+    }
+    synchronize(s);
+
+    const Minisat::lbool result = (m_mode == Mode::Cubes) ? conquer(s, layout, assumptions) : race(s, layout, assumptions);
+
+    s.clearInterrupt();
+    for (auto& copy: m_copies)
+    {
+        copy->clearInterrupt();
+    }
+    return result;
+}
+
+
+void Portfolio::solveEach(SatSolver& s, const FormulaLayout& layout, const std::vector<std::vector<Minisat::Lit>>& queries,
+                          std::vector<Minisat::lbool>& results, std::vector<std::vector<Minisat::Lit>>& conflicts)
+{
+    synchronize(s);
+
+    // one slot per query, so the members never write to shared memory
+    std::vector<Minisat::lbool> answers(queries.size(), l_Undef);
+    conflicts.assign(queries.size(), std::vector<Minisat::Lit>());
+    const auto run = [&](int i)
+    {
+        SatSolver& solver = member(s, i);
+        Minisat::vec<Minisat::Lit> assumptions;
+        for (auto lit: queries[i])
+        {
+            assumptions.push(lit);
+        }
+        answers[i] = solvePath(solver, layout, assumptions);
+        if (answers[i] == l_False)
+        {
+            for (int j = 0; j < solver.conflict.size(); ++j)
+            {
+                conflicts[i].push_back(solver.conflict[j]);
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < static_cast<int>(queries.size()); ++i)
+    {
+        threads.emplace_back(run, i);
+    }
+    if (!queries.empty())
+    {
+        run(0);
+    }
+    for (auto& thread: threads)
+    {
+        thread.join();
+    }
+
+    s.clearInterrupt();
+    for (auto& copy: m_copies)
+    {
+        copy->clearInterrupt();
+    }
+    results.assign(answers.begin(), answers.end());
+}
+
+
+Minisat::lbool Portfolio::race(SatSolver& s, const FormulaLayout& layout, const Minisat::vec<Minisat::Lit>& assumptions)
+{
+    // the first member to finish wins; the interrupted members' answers are void (if the caller interrupted the
+    // query, the first member to stop wins with l_Undef)
+    std::atomic<int> winner(-1);
+    Minisat::lbool answer = l_Undef;
+    const auto run = [&](int member, SatSolver& solver)
+    {
+        const Minisat::lbool result = solvePath(solver, layout, assumptions);
+        int none = -1;
+        if (winner.compare_exchange_strong(none, member))
+        {
+            answer = result;
+            s.interrupt();
+            interrupt();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < static_cast<int>(m_copies.size()); ++i)
+    {
+        threads.emplace_back(run, i + 1, std::ref(*m_copies[i]));
+    }
+    run(0, s);
+    for (auto& thread: threads)
+    {
+        thread.join();
+    }
+
+    const int member = winner;
+    if (answer == l_Undef)
+    {
+        return l_Undef;
+    }
+    ++m_wins[member];
+    if (member > 0)
+    {
+        const SatSolver& copy = *m_copies[member - 1];
+        copy.model.copyTo(s.model);
+        copy.conflict.copyTo(s.conflict);
+    }
+    return answer;
+}
+
+
+Minisat::lbool Portfolio::conquer(SatSolver& s, const FormulaLayout& layout, const Minisat::vec<Minisat::Lit>& assumptions)
+{
+    // the formula states that the path has an entry (or, in the edge encoding, two ends) among the edge fields, so
+    // the cubes cover all paths; pruned entries have no literal, and interior fields (which the binary encoding gives
+    // an entry literal as well) would only make trivially unsatisfiable cubes
+    std::vector<Minisat::Lit> cubes;
+    for (auto field: getEdgeFields(layout.width(), layout.height()))
+    {
+        const Minisat::Lit lit = layout.entryLit(field);
+        if (lit != Minisat::lit_Undef)
+        {
+            cubes.push_back(lit);
+        }
+    }
+
+    std::atomic<int> next(0);
+    std::atomic<int> satisfiable(-1);
+    // a cube was interrupted by the caller (not by a satisfiable cube): the query has no answer
+    std::atomic<bool> interrupted(false);
+    // per member: the assumptions used by its unsatisfiable cubes
+    std::vector<std::vector<Minisat::Lit>> cores(size());
+    const auto run = [&](int i)
+    {
+        SatSolver& solver = member(s, i);
+        Minisat::vec<Minisat::Lit> cubeAssumptions;
+        assumptions.copyTo(cubeAssumptions);
+        cubeAssumptions.push(Minisat::lit_Undef);
+
+        for (int cube = next++; cube < static_cast<int>(cubes.size()) && satisfiable < 0 && !interrupted; cube = next++)
+        {
+            cubeAssumptions.last() = cubes[cube];
+            const Minisat::lbool result = solvePath(solver, layout, cubeAssumptions);
+            if (satisfiable >= 0)
+            {
+                // interrupted by a satisfiable cube
+                return;
+            }
+            if (result == l_Undef)
+            {
+                interrupted = true;
+                return;
+            }
+            ++m_wins[i];
+            if (result == l_True)
+            {
+                int none = -1;
+                if (satisfiable.compare_exchange_strong(none, i))
+                {
+                    s.interrupt();
+                    interrupt();
+                }
+                return;
+            }
+            for (int j = 0; j < solver.conflict.size(); ++j)
+            {
+                if (solver.conflict[j] != ~cubes[cube]) cores[i].push_back(solver.conflict[j]);
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < size(); ++i)
+    {
+        threads.emplace_back(run, i);
+    }
+    run(0);
+    for (auto& thread: threads)
+    {
+        thread.join();
+    }
+
+    if (satisfiable >= 0)
+    {
+        if (satisfiable > 0)
+        {
+            m_copies[satisfiable - 1]->model.copyTo(s.model);
+        }
+        return l_True;
+    }
+
+    if (interrupted)
+    {
+        return l_Undef;
+    }
+
+    // all cubes are unsatisfiable: the union of their cores is a core of the query
+    std::vector<bool> seen(2 * s.nVars(), false);
+    s.conflict.clear();
+    for (const auto& core: cores)
+    {
+        for (auto lit: core)
+        {
+            if (!seen[Minisat::toInt(lit)])
+            {
+                seen[Minisat::toInt(lit)] = true;
+                s.conflict.push(lit);
+            }
+        }
+    }
+    return l_False;
+}
@@ -0,0 +1,86 @@
+/*******************************************************************************
+* alcazar-gen
+*
+* Copyright (c) 2015 Florian Pigorsch
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <core/SolverTypes.h>
+#include <mtl/Vec.h>
+
+#include "formula.h"
+#include "satSolver.h"
+
+// Copies of a solver with diversified heuristics (random seed, restarts, phase saving) that answer queries in
+// parallel with the solver. A single query is answered in one of three ways:
+// - alone: the solver runs it; the copies only serve solveEach
+// - race: every member runs the full query; the first answer wins and interrupts the others
+// - cubes (cube and conquer): the query is split into one cube per possible entry field of the path; the members take
+//   cubes until one is satisfiable (which interrupts the others) or all are unsatisfiable
+// The copies follow the solver through its recording: before a query they get all clauses added to the solver since
+// the previous query.
+class Portfolio
+{
+    public:
+        enum class Mode
+        {
+            Alone,
+            Race,
+            Cubes
+        };
+
+        // size - 1 copies
+        Portfolio(int size, Mode mode);
+
+        int size() const { return static_cast<int>(m_copies.size()) + 1; }
+        Mode mode() const { return m_mode; }
+
+        // solvePath on the solver (which has to record its clauses) and the copies; the model of a satisfiable
+        // answer or the conflict of an unsatisfiable one is copied into s; l_Undef if interrupted
+        Minisat::lbool solve(SatSolver& s, const FormulaLayout& layout, const Minisat::vec<Minisat::Lit>& assumptions);
+
+        // different queries at once: query i (at most size()) runs on member i; sets each query's answer (l_Undef if
+        // interrupted) and, if unsatisfiable, its conflict
+        void solveEach(SatSolver& s, const FormulaLayout& layout, const std::vector<std::vector<Minisat::Lit>>& queries,
+                       std::vector<Minisat::lbool>& results, std::vector<std::vector<Minisat::Lit>>& conflicts);
+
+        // interrupt the copies' running query (thread-safe); the interrupt is cleared at the end of the query
+        void interrupt();
+
+        // number of queries answered first (cubes: cubes solved) by member i (0: the solver itself)
+        int wins(int member) const { return m_wins[member]; }
+
+    private:
+        void synchronize(const SatSolver& s);
+        Minisat::lbool race(SatSolver& s, const FormulaLayout& layout, const Minisat::vec<Minisat::Lit>& assumptions);
+        Minisat::lbool conquer(SatSolver& s, const FormulaLayout& layout, const Minisat::vec<Minisat::Lit>& assumptions);
+        SatSolver& member(SatSolver& s, int i) { return (i == 0) ? s : *m_copies[i - 1]; }
+
+        std::vector<std::unique_ptr<SatSolver>> m_copies;
+        Mode m_mode;
+        std::vector<int> m_wins;
+        // clauses of the solver's recording the copies already have
+        int m_synchronized = 0;
+};
@@ -0,0 +1,110 @@
+/*******************************************************************************
+* alcazar-gen
+*
+* Copyright (c) 2015 Florian Pigorsch
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "race.h"
+
+
+GeneratorResult race(const TemplateBoard& templateBoard, const Options& options, std::ostream& log)
+{
+    unsigned int master = options.seed;
+    if (master == 0)
+    {
+        master = std::random_device()();
+    }
+
+    PreparedFormula formula;
+    prepareFormula(templateBoard, options.formula, options.formulaCache, formula, log);
+
+    const int count = options.race;
+    std::vector<unsigned int> seeds;
+    std::vector<std::ostringstream> logs(count);
+    std::vector<std::unique_ptr<Generator>> generators;
+    for (int i = 0; i < count; ++i)
+    {
+        seeds.push_back(deriveSeed(master, i));
+
+        // racing generators share the dump/import files otherwise
+        DimacsOptions dimacs = options.dimacs;
+        if (!dimacs.dumpPrefix.empty()) dimacs.dumpPrefix += "-race" + std::to_string(i);
+        if (!dimacs.importPrefix.empty()) dimacs.importPrefix += "-race" + std::to_string(i);
+
+        generators.emplace_back(new Generator(templateBoard, options.formula, dimacs, options.solver, options.formulaCache, seeds[i], logs[i]));
+        generators.back()->setFormula(&formula);
+    }
+    log << "Info: racing " << count << " generators, master seed " << master << std::endl;
+
+    std::mutex mutex;
+    int winner = -1;
+    GeneratorResult result;
+    const auto run = [&](int i)
+    {
+        GeneratorResult candidate = generators[i]->get();
+        if (candidate.board.width() == 0)
+        {
+            // failed or cancelled
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (winner >= 0)
+        {
+            return;
+        }
+        winner = i;
+        result = candidate;
+        for (int j = 0; j < count; ++j)
+        {
+            if (j != i) generators[j]->cancel();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < count; ++i)
+    {
+        threads.emplace_back(run, i);
+    }
+    run(0);
+    for (auto& thread: threads)
+    {
+        thread.join();
+    }
+
+    if (winner < 0)
+    {
+        // every generator failed for the same reason (e.g. the template); show one of the logs
+        log << logs[0].str();
+        return GeneratorResult();
+    }
+
+    log << logs[winner].str();
+    log << "Info: generator " << winner << " (seed " << seeds[winner] << ") finished first; --seed " << seeds[winner] << " reproduces the puzzle" << std::endl;
+    return result;
+}
@@ -0,0 +1,128 @@
+/*******************************************************************************
+* alcazar-gen
+*
+* Copyright (c) 2015 Florian Pigorsch
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+
+#pragma once
+
+#include <cstdlib>
+#include <vector>
+
+#include <core/SolverTypes.h>
+#include <simp/SimpSolver.h>
+
+#include "clauseSink.h"
+
+struct SolverOptions
+{
+    // number of diversified solvers racing on each query
+    int portfolio = 1;
+    // number of solvers splitting each query into cubes (cube and conquer; excludes portfolio)
+    int cubes = 1;
+    // number of wall removal candidates the generator tests at once, on as many solvers
+    int speculate = 1;
+    // the generator adds a wall blocking the alternative path of the last query instead of a random wall
+    bool blockAlternatives = false;
+    // the generator finds the needed walls by divide and conquer (QuickXplain) instead of adding and removing walls one by one
+    bool quickXplain = false;
+    // the generator drops the walls that no alternative path crosses while adding walls (edge encoding only)
+    bool backbone = false;
+    // consecutive puzzles of a batch worker share one solver (puzzle clauses are guarded by activation literals)
+    bool reuse = false;
+    // the formula is preprocessed once (variable elimination, subsumption) before the first query; otherwise the
+    // solver's preprocessing is turned off before the formula is added (see SatSolver::disablePreprocessing)
+    bool preprocess = true;
+};
+
+
+// The solver of all path queries. It can keep a copy of every clause added through it, i.e. of the exact
+// formula as built (the solver itself simplifies the clauses and drops satisfied ones).
+class SatSolver : public Minisat::SimpSolver
+{
+    public:
+        void setRecording(bool record) { m_record = record; }
+        bool recording() const { return m_record; }
+        const ClauseBuffer& recorded() const { return m_recorded; }
+
+        bool addClause(const Minisat::vec<Minisat::Lit>& ps)
+        {
+            if (m_record) m_recorded.addClause(ps);
+            return Minisat::SimpSolver::addClause(ps);
+        }
+        bool addClause(Minisat::Lit p)
+        {
+            if (m_record) m_recorded.addClause(p);
+            return Minisat::SimpSolver::addClause(p);
+        }
+        bool addClause(Minisat::Lit p, Minisat::Lit q)
+        {
+            if (m_record) m_recorded.addClause(p, q);
+            return Minisat::SimpSolver::addClause(p, q);
+        }
+        bool addClause(Minisat::Lit p, Minisat::Lit q, Minisat::Lit r)
+        {
+            if (m_record) m_recorded.addClause(p, q, r);
+            return Minisat::SimpSolver::addClause(p, q, r);
+        }
+
+        // Queries never start the preprocessing: on its first call, SimpSolver::solve would eliminate all variables
+        // except the assumed ones, although later queries assume, extract or block them. l_Undef if interrupted.
+        Minisat::lbool solveLimited(const Minisat::vec<Minisat::Lit>& assumptions) { return Minisat::SimpSolver::solveLimited(assumptions, false); }
+
+        // Runs the preprocessing (bounded variable elimination, subsumption) once on the clauses added so far and turns
+        // it off for good. The frozen variables are kept. Returns false if the formula is unsatisfiable.
+        bool preprocess(const std::vector<Minisat::Var>& frozen);
+
+        // Turns the preprocessing off for good before any clause is added: the solver then keeps no occurrence lists
+        // and works like a plain Minisat::Solver.
+        void disablePreprocessing() { eliminate(true); }
+
+        static int toDimacs(Minisat::Lit lit) { return Minisat::sign(lit) ? -(Minisat::var(lit) + 1) : (Minisat::var(lit) + 1); }
+        static Minisat::Lit fromDimacs(int lit) { return Minisat::mkLit(std::abs(lit) - 1, lit < 0); }
+
+    private:
+        bool m_record = false;
+        ClauseBuffer m_recorded;
+};
+
+
+// Adds the formula to a solver.
+class SolverSink : public ClauseSink
+{
+    public:
+        explicit SolverSink(SatSolver& s) : m_solver(s) {}
+
+        Minisat::Var newVar() override { return m_solver.newVar(); }
+        int nVars() const override { return m_solver.nVars(); }
+
+    protected:
+        void addClause_(const Minisat::Lit* lits, int size) override
+        {
+            m_clause.clear();
+            for (int i = 0; i < size; ++i) m_clause.push(lits[i]);
+            m_solver.addClause(m_clause);
+        }
+
+    private:
+        SatSolver& m_solver;
+        Minisat::vec<Minisat::Lit> m_clause;
+};
@@ -13,6 +13,7 @@
  ************************************************/
 
 #include "templateBoard.h"
+#include <fstream>
 #include <string>
 #include <vector>
 
@@ -310,3 +311,20 @@ std::ostream& operator<<(std::ostream& os, const TemplateBoard& b)
 
     return os;
 }
+
+
+bool readTemplateFile(const std::string& fileName, TemplateBoard& board)
+{
+    std::ifstream file(fileName);
+    if (!file)
+    {
+        std::cout << "Error: cannot open template file '" << fileName << "' for reading" << std::endl;
+        return false;
+    }
+    if (!board.parse(file))
+    {
+        std::cout << "Error: syntax error in template file '" << fileName << "'" << std::endl;
+        return false;
+    }
+    return true;
+}
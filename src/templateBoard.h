@@ -18,6 +18,7 @@
 #include "wall.h"
 #include <iostream>
 #include <set>
+#include <string>
 #include <vector>
 
 class TemplateBoard
@@ -50,3 +51,6 @@ class TemplateBoard
 };
 
 std::ostream& operator<<(std::ostream& os, const TemplateBoard& b);
+
+// parse the template file; prints an error and returns false if it cannot be read or parsed
+bool readTemplateFile(const std::string& fileName, TemplateBoard& board);
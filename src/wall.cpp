@@ -31,6 +31,28 @@ Wall::Wall(const Coordinates& coordinates, Orientation orientation) :
 {}
 
 
+int Wall::id(int width, int height) const
+{
+    if (m_orientation == Orientation::V)
+    {
+        return m_coordinates.x() + m_coordinates.y() * (width + 1);
+    }
+    return height * (width + 1) + m_coordinates.x() + m_coordinates.y() * width;
+}
+
+
+Wall Wall::fromId(int id, int width, int height)
+{
+    const int vertical = height * (width + 1);
+    if (id < vertical)
+    {
+        return Wall({id % (width + 1), id / (width + 1)}, Orientation::V);
+    }
+    id -= vertical;
+    return Wall({id % width, id / width}, Orientation::H);
+}
+
+
 bool Wall::isBetween(const Coordinates& c1, const Coordinates& c2) const
 {
     if (c1.x() == c2.x() && m_orientation == Orientation::H)
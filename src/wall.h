@@ -40,6 +40,12 @@ class Wall
         
         bool isBetween(const Coordinates& c1, const Coordinates& c2) const;
         
+        // dense index of the wall position on a width x height board:
+        // vertical walls row by row, followed by horizontal walls row by row
+        int id(int width, int height) const;
+        static Wall fromId(int id, int width, int height);
+        static int count(int width, int height) { return height * (width + 1) + (height + 1) * width; }
+        
         Coordinates m_coordinates;
         Orientation m_orientation = Orientation::H;
 };
@@ -0,0 +1,118 @@
+/*******************************************************************************
+* alcazar-gen
+*
+* Copyright (c) 2015 Florian Pigorsch
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "workStealingPool.h"
+
+
+WorkStealingPool::WorkStealingPool(int workers) :
+    m_stats(std::max(workers, 1))
+{
+    for (int i = 0; i < std::max(workers, 1); ++i)
+    {
+        m_queues.emplace_back(new Queue());
+    }
+}
+
+
+void WorkStealingPool::add(std::function<void(int)> task, int priority)
+{
+    m_pending.push_back({task, priority});
+}
+
+
+void WorkStealingPool::run()
+{
+    std::stable_sort(m_pending.begin(), m_pending.end(), [](const Task& a, const Task& b) { return a.priority > b.priority; });
+    for (unsigned int i = 0; i < m_pending.size(); ++i)
+    {
+        m_queues[i % m_queues.size()]->tasks.push_back(m_pending[i]);
+    }
+    m_pending.clear();
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int worker = 1; worker < workers(); ++worker)
+    {
+        threads.emplace_back(&WorkStealingPool::work, this, worker);
+    }
+    work(0);
+    for (auto& thread: threads)
+    {
+        thread.join();
+    }
+    m_wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+void WorkStealingPool::work(int worker)
+{
+    WorkerStats& stats = m_stats[worker];
+    Task task;
+    for (;;)
+    {
+        if (!takeOwn(worker, task))
+        {
+            // tasks never add tasks, so once no queue has any left, the worker is done
+            if (!steal(worker, task)) return;
+            ++stats.stolen;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        task.run(worker);
+        stats.busySeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        ++stats.tasks;
+    }
+}
+
+
+bool WorkStealingPool::takeOwn(int worker, Task& task)
+{
+    Queue& queue = *m_queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) return false;
+    task = queue.tasks.front();
+    queue.tasks.pop_front();
+    return true;
+}
+
+
+bool WorkStealingPool::steal(int worker, Task& task)
+{
+    for (int i = 1; i < workers(); ++i)
+    {
+        Queue& queue = *m_queues[(worker + i) % workers()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty())
+        {
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
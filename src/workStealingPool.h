@@ -0,0 +1,80 @@
+/*******************************************************************************
+* alcazar-gen
+*
+* Copyright (c) 2015 Florian Pigorsch
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Thread pool for independent tasks of very different run times. The tasks are dealt to per-worker queues in order of
+// priority; a worker runs its own queue front to back, and when it is empty steals the next task of another worker's
+// queue, so no worker idles while tasks are pending and high priority tasks still start first.
+class WorkStealingPool
+{
+    public:
+        struct WorkerStats
+        {
+            int tasks = 0;
+            int stolen = 0;
+            double busySeconds = 0;
+        };
+
+        explicit WorkStealingPool(int workers);
+
+        // higher priorities run first; tasks of equal priority run in the order they were added; a task receives the
+        // index of the worker running it
+        void add(std::function<void(int)> task, int priority = 0);
+
+        // run all tasks on the workers (the calling thread is worker 0); blocks until all tasks are done
+        void run();
+
+        int workers() const { return static_cast<int>(m_queues.size()); }
+        const WorkerStats& stats(int worker) const { return m_stats[worker]; }
+        double wallSeconds() const { return m_wallSeconds; }
+
+    private:
+        struct Task
+        {
+            std::function<void(int)> run;
+            int priority;
+        };
+
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        void work(int worker);
+        bool takeOwn(int worker, Task& task);
+        bool steal(int worker, Task& task);
+
+        std::vector<Task> m_pending;
+        std::vector<std::unique_ptr<Queue>> m_queues;
+        std::vector<WorkerStats> m_stats;
+        double m_wallSeconds = 0;
+};